@@ -41,18 +41,128 @@
 	.				The rules have been adapted from https://www.pagat.com/banking/pontoon.html
 */
 	
+#define _GNU_SOURCE //accept4
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <signal.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 enum suitEnum {DIAMONDS=1, HEARTS, CLUBS, SPADES};
 enum kindEnum {ACE=1, TWO, THREE, FOUR, FIVE, SIX, SEVEN, EIGHT, NINE, TEN, JACK, QUEEN, KING};
 enum handRankingEnum {BLACKJACK = 1, FIVE_CARD_TRICK, TWENTYONE, NOT_BUST, BUST}; //represents a card ranking
 
-struct card{ //represents a card
-	enum suitEnum suit;
-	enum kindEnum kind;
+struct card{ //represents a card in one byte: 0 is an empty slot, otherwise (suit-1)*13 + kind, so 1 to 52
+	unsigned char code;
+};
+
+#define TRICK_MAX 6 //most cards a hand can hold, for the six card trick variant
+
+struct hand{ //up to TRICK_MAX cards, size and totals are kept up to date by handAdd so nothing has to rescan the cards
+	struct card cards[TRICK_MAX];
+	unsigned char size;
+	unsigned char hardTotal; //aces counted as one
+	unsigned char aces;
+};
+
+#define SHOE_MAX_DECKS 8
+#define SHOE_MAX (52 * SHOE_MAX_DECKS)
+#define SHOE_DECKS 1 //decks in a new game's shoe unless --decks says otherwise
+#define SHOE_PENETRATION 75 //percent of the shoe dealt before the cut card comes out
+
+struct shoe{ //one or more decks, dealt from round after round until the cut card comes out
+	int decks;
+	int cut; //once drawPosition reaches this the shoe is reshuffled before the next round
+	struct card cards[SHOE_MAX]; //cards[0] to cards[drawPosition-1] have been dealt
+};
+
+#define HAND_BATCH 256 //hands per batch, a multiple of 32 so the simd loops never need a tail
+
+struct handBatch{ //hands laid out struct-of-arrays for scoring many at once
+	unsigned char cards[5][HAND_BATCH]; //card codes, slot i of every hand stored together (0 = empty slot)
+	unsigned char value[HAND_BATCH]; //filled in by handBatchResolve
+	unsigned char ranking[HAND_BATCH]; //enum handRankingEnum
+};
+
+#define RANKS 10 //card values for working out odds: ace, 2-9, then every 10 point card together
+#define DEALER_OUTCOMES 8
+#define DEALER_KEY 16 //bytes in a dealer cache key
+
+enum dealerOutcomeEnum {OUTCOME_BUST = 0, OUTCOME_17, OUTCOME_18, OUTCOME_19, OUTCOME_20, OUTCOME_21, OUTCOME_FIVE_CARD_TRICK, OUTCOME_BLACKJACK};
+
+struct deckCounts{ //cards left by points value: [0] aces ... [9] tens and pictures
+	unsigned char count[RANKS];
+	int total;
+};
+
+struct dealerOdds{ //chance of each way the dealer's hand can finish, indexed by enum dealerOutcomeEnum
+	double p[DEALER_OUTCOMES];
+};
+
+struct dealerCacheEntry{
+	unsigned char key[DEALER_KEY]; //deck counts, hard total, has ace, size
+	unsigned char used;
+	struct dealerOdds odds;
+};
+
+struct dealerCache{ //memoized dealer odds keyed on hand and deck composition, one per thread
+	struct dealerCacheEntry *entries;
+	long capacity; //power of two
+	long used;
+	long hits;
+	long misses;
+};
+
+#define STRATEGY_MAGIC "BJSTRAT" //strategy.bin starts with this
+#define STRATEGY_VERSION 1
+#define STRATEGY_HANDS 1000 //player hands of 1 to 4 cards by rank, see strategyHandIndex
+#define STRATEGY_STAKES 8 //total bet in initial bets, 1 to 7
+#define STRATEGY_CAPS 3 //first buy in initial bets: 0 not bought yet, 1 or 2
+#define STRATEGY_ENTRIES (RANKS * STRATEGY_HANDS * STRATEGY_STAKES * STRATEGY_CAPS)
+
+enum strategyActionEnum {STRAT_NONE = 0, STRAT_STICK, STRAT_TWIST, STRAT_BUY_LOW, STRAT_BUY_HIGH}; //buys at the bottom or top of the range
+
+struct strategyTable{ //solver output, written and read as one block
+	char magic[8];
+	int version;
+	int entries;
+	float betEv[RANKS][RANKS]; //[first card][upcard]: EV per $1 of initial bet, before the second cards
+	unsigned char action[STRATEGY_ENTRIES]; //[upcard][hand][stake][first buy], enum strategyActionEnum
+	short ev[STRATEGY_ENTRIES]; //EV of that action in thousandths of the initial bet
+};
+
+struct solverWorker{ //one solver thread, works through one dealer upcard at a time
+	struct strategyTable *table;
+	atomic_int *nextUpcard;
+	struct dealerCache cache;
+	int upcard;
+	struct deckCounts remaining; //deck less the upcard and the player's cards
+	unsigned char held[RANKS]; //player's cards by rank
+	unsigned char solved[STRATEGY_HANDS * STRATEGY_STAKES * STRATEGY_CAPS];
+	double memo[STRATEGY_HANDS * STRATEGY_STAKES * STRATEGY_CAPS];
+	pthread_t thread;
 };
 
 struct player{ //used to save player scores to leaderboard
@@ -70,1172 +180,6584 @@ struct gameVars{ //used to save game variables
 	int gameState;
 };
 
+#define SAVE_PATH "save.bin"
+#define SAVE_TEXT_PATH "save.txt" //the old format, converted the first time it's found
+#define SAVE_MAGIC "BJ_SAVE"
+#define SAVE_VERSION 2 //1 had a single 52 card deck, upgraded when it's read
+
+struct saveFile{ //save.bin: one block at fixed offsets, read and written in one call each
+	char magic[8];
+	int version;
+	int size; //sizeof(struct saveFile), catches a file from a build with a different layout
+	unsigned int crc; //crc32 of everything after this field
+	struct player leaderboard[10];
+	struct player current;
+	struct shoe shoe;
+	struct card playerCards[TRICK_MAX];
+	struct card dealerCards[TRICK_MAX];
+	struct gameVars vars;
+};
+
+struct saveFileV1{ //save.bin before the shoe, only read to upgrade it
+	char magic[8];
+	int version;
+	int size;
+	unsigned int crc;
+	struct player leaderboard[10];
+	struct player current;
+	struct card deck[52];
+	struct card playerCards[TRICK_MAX];
+	struct card dealerCards[TRICK_MAX];
+	struct gameVars vars;
+};
+
+#define JOURNAL_MAGIC "BJ_JRNL"
+#define JOURNAL_PATH_MAX 256
+#define JOURNAL_SYNC_EVERY 8 //records between fsyncs
+#define JOURNAL_COMPACT 256 //records before the journal is folded back into save.bin
+
+struct journalHeader{ //start of save.bin.journal
+	char magic[8];
+	unsigned int saveCrc; //crc of the save.bin the records go on top of
+};
+
+struct journalRecord{ //one finished hand, fixed size so a torn last record is easy to spot
+	unsigned int crc; //crc32 of the rest of the record
+	unsigned int sequence; //1, 2, 3... since the journal was started
+	struct player player;
+	struct gameVars vars;
+};
+
+struct journal{ //append-only log of hands since save.bin was last written
+	int fd; //-1 when not open
+	long records;
+	int unsynced; //records written since the last fsync
+	unsigned int saveCrc;
+};
+
+struct saveWriter{ //background thread that puts save snapshots on disk so the game never waits for it
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake; //a snapshot is waiting, or it's time to stop
+	pthread_cond_t done; //a write finished
+	struct saveFile buffers[2]; //the game fills one while the writer works from the other
+	int pending; //buffer waiting to be written, -1 if none
+	int writing; //buffer being written, -1 if idle
+	int stop;
+	char path[JOURNAL_PATH_MAX];
+	long submitted, coalesced, completed; //snapshots handed over, replaced before they were written, written
+	int failed; //failed writes the game hasn't been told about yet
+	unsigned int crc; //last snapshot that made it to disk, and its file's size/mtime
+	long long size;
+	struct timespec mtime;
+};
+
+struct saveCache{ //the save as last read or written, only read again when the file changes underneath it
+	struct saveFile save;
+	struct journal journal; //hands played since save was written
+	struct saveWriter *writer; //writes go through it when set, otherwise they're synchronous
+	long writesSeen; //writer->completed when last polled
+	unsigned int durableCrc; //crc of the save.bin actually on disk, what the journal has to be started against
+	int loaded;
+	int valid; //validFile when it was read
+	long long size; //of the file when it was read/written
+	struct timespec mtime;
+	long reads, stats; //file reads and stats so far, for --bench-menu
+};
+
+#define PROFILE_PATH "profiles.db"
+#define PROFILE_MAGIC "BJ_PROF"
+#define PROFILE_VERSION 2 //1 had a single 52 card deck per slot, upgraded when the store is opened
+#define PROFILE_NAME 16 //same as player.name
+#define PROFILE_START_CAPACITY 1024 //slots (and hash buckets) in a new store, doubles when full
+
+struct profileHeader{ //start of profiles.db, then capacity hash buckets (first slot of each chain), then capacity slots
+	char magic[8];
+	int version;
+	int slotSize; //sizeof(struct profileSlot)
+	long capacity;
+	long used;
+	int freeHead; //deleted slots, chained through next
+	int nextUnused; //slots from here on have never been used
+};
+
+struct profileSlot{ //one player's saved game, fixed size so slot i is always at the same offset
+	int next; //next slot in the same bucket (or on the free list), -1 at the end
+	int inUse;
+	unsigned int crc; //crc32 of everything after this field
+	struct player player;
+	struct gameVars vars;
+	struct shoe shoe;
+	struct card playerCards[TRICK_MAX];
+	struct card dealerCards[TRICK_MAX];
+};
+
+struct profileSlotV1{ //profiles.db slot before the shoe, only read to upgrade the store
+	int next;
+	int inUse;
+	unsigned int crc;
+	struct player player;
+	struct gameVars vars;
+	struct card deck[52];
+	struct card playerCards[TRICK_MAX];
+	struct card dealerCards[TRICK_MAX];
+};
+
+struct profileStore{ //profiles.db mapped into memory, only the pages of the profiles used get touched
+	char path[JOURNAL_PATH_MAX];
+	int fd;
+	void *map;
+	long mapSize;
+	struct profileHeader *header;
+	ino_t inode; //to notice another process replacing the file with a bigger one
+};
+
+struct rng{ //random number stream (xoshiro256**), each game has its own so threads never share one
+	unsigned long long s[4];
+};
+
+#define RANK_PATH "leaderboard.db"
+#define RANK_MAGIC "BJ_RANK"
+#define RANK_VERSION 1
+#define RANK_MAX_LEVEL 32 //skip list levels, plenty for 4^32 players
+#define RANK_LOG_COMPACT 4096 //logged submissions before leaderboard.db is rewritten, or one per player ranked if that's more
+
+struct rankLink{
+	struct rankNode *next;
+	long span; //places between this node and next
+};
+
+struct rankNode{ //one player on the board
+	struct player player;
+	struct rankNode *hashNext; //next in the same name bucket
+	int level;
+	struct rankLink links[]; //level of them
+};
+
+struct rankBoard{ //every player's best score ever, a skip list in rank order plus a name index
+	struct rankNode *head; //not a player, links into every level
+	int level;
+	long count;
+	struct rankNode **buckets;
+	long bucketCount;
+	struct rng rng; //node levels
+	char path[JOURNAL_PATH_MAX]; //empty for a board only kept in memory
+	int logFd; //leaderboard.db.log, submissions since the last rewrite
+	long logged;
+};
+
+struct rankFileHeader{ //start of leaderboard.db, then count players best first
+	char magic[8];
+	int version;
+	int entrySize; //sizeof(struct player)
+	long count;
+};
+
+struct rankRecord{ //one submission in leaderboard.db.log
+	unsigned int crc; //crc32 of player
+	struct player player;
+};
+
+#define RANK_SHARDS 16 //submission buffers, picked by name hash
+#define RANK_SHARD_PENDING 512 //submissions a shard holds before the submitter merges them itself
+#define RANK_SNAPSHOT_TOP 100 //places readers can see without touching the board
+#define RANK_MERGE_MS 50 //how often the merge thread empties the shards
+
+struct rankShard{ //submissions waiting to be merged, one lock per shard so sessions rarely meet
+	pthread_mutex_t lock;
+	int count;
+	struct player pending[RANK_SHARD_PENDING];
+};
+
+struct rankSnapshot{ //the top of the board as of the last merge
+	long count; //players ranked
+	int filled;
+	struct player top[RANK_SNAPSHOT_TOP];
+};
+
+struct rankShared{ //a rankBoard many sessions can submit to at once
+	struct rankBoard board; //the ranking is only touched under boardLock, its files (logFd, logged) only under logLock
+	pthread_mutex_t boardLock;
+	struct player draining[RANK_SHARD_PENDING]; //a shard's buffer copied out, so its lock isn't held while merging
+	struct player *unlogged; //merged submissions that changed the board, waiting to be written to the log
+	long unloggedCount, unloggedCapacity;
+	struct player *logging; //the batch being written, swapped with unlogged under boardLock
+	long loggingCapacity;
+	int rewrite; //an unlogged submission couldn't be kept (out of memory), so the next write is a full rewrite
+	pthread_mutex_t logLock; //held while writing leaderboard.db and its log, so boardLock never waits on the disk
+	struct rankShard shards[RANK_SHARDS];
+	atomic_uint snapshotSeq; //odd while snapshot is being rewritten
+	struct rankSnapshot snapshot;
+	long merged, merges; //submissions merged and merges done
+	pthread_t merger;
+	int merging; //merger thread running
+	pthread_mutex_t timerLock;
+	pthread_cond_t timer;
+	int mergeMs;
+	int stop;
+};
+
+#define SCREEN_BYTES 8192 //text in one frame, the info screens are the longest at under 2K
+#define SCREEN_LINES 128
+
+struct screen{ //the frame being built and the last one sent, so only the lines that changed get sent again
+	char text[SCREEN_BYTES];
+	int length;
+	int sent; //bytes of text already written, when output isn't a terminal
+	char shown[SCREEN_BYTES]; //what the terminal is showing
+	int shownLength;
+	int starts[SCREEN_LINES], lengths[SCREEN_LINES];
+	int shownStarts[SCREEN_LINES], shownLengths[SCREEN_LINES];
+	char out[2 * SCREEN_BYTES]; //escapes and changed lines, built up then written in one go
+	int outLength;
+	int terminal; //isatty, -1 until the first flush
+	int fresh; //the terminal hasn't been cleared yet
+};
+
+struct game{ //everything needed to play a game, driven by the game* engine functions (no I/O)
+	struct player player;
+	struct rng rng;
+	struct shoe shoe;
+	struct hand playerHand;
+	struct hand dealerHand;
+	struct gameVars vars;
+	long roundResult; //money won (+) or lost (-) in the last settled round
+	int decks, penetration; //shoe gameNew sets up, a loaded game keeps the shoe it was saved with
+};
+
+#define TABLE_SEATS 7 //most seats at one table
+_Static_assert((TABLE_SEATS + 1) * TRICK_MAX <= 52, "a full round at a full table has to fit in one deck");
+
+struct seat{ //one player at a table: their hand, bets and money, the shoe and the dealer's hand are the table's
+	struct player player;
+	struct hand hand;
+	struct gameVars vars; //gameState as in struct game (0 betting, 1 bet in, 2 playing, 4 waiting on the dealer, 6 done), drawPosition unused
+	long roundResult;
+};
+
+struct table{ //up to TABLE_SEATS seats against one dealer hand, all dealt from one shoe round after round
+	struct rng rng;
+	struct shoe shoe;
+	int drawPosition;
+	struct hand dealerHand;
+	int seats;
+	int turn; //the seat playing while state is 2, seats take their whole turn one after the other
+	int state; //0 bets, 2 and 3 the seats' turns (their own gameStates), 4 dealer, 5 settling, 6 round over
+	long rounds, shuffles, dealerTurns; //shuffles counts the first fill, dealerTurns the rounds the dealer had to play
+	struct seat seat[TABLE_SEATS];
+	struct game view; //one seat's hand and vars with the dealer's hand, what a playerPolicy reads, its shoe is never used
+};
+
+#define SESSION_LINE 64 //longest line of input a session takes
+#define SERVER_BACKLOG 1024 //connections waiting to be accepted
+#define SERVER_EVENTS 256 //epoll events handled per wait
+#define LOAD_REPLY 1024 //end of a reply the load generator keeps
+#define LOAD_ACTIONS 100000
+#define LOAD_SESSIONS 100
+#define HIBERNATE_PATH "sessions.db" //idle sessions of a running server, started afresh each run
+#define SESSION_IDLE_SECONDS 60 //a session with no input for this long goes to HIBERNATE_PATH
+#define SESSION_MEMORY_MB 256 //packed sessions kept in memory, least recently used go to the file past this
+
+//what a session's next line of input answers
+enum sessionStepEnum {STEP_TITLE = 1, STEP_NAME, STEP_PROFILE, STEP_BET, STEP_ACTION, STEP_BUY, STEP_CONTINUE, STEP_AGAIN, 
+	STEP_INFO, STEP_BACK, STEP_DONE, STEP_ABORT};
+
+struct sessionHost{ //what every session in the process shares
+	struct saveCache *saveCache; //save.bin, its leaderboard and last game, only the interactive game has one
+	struct profileStore *profiles; //NULL if it couldn't be opened
+	struct rankShared *board;
+	struct strategyTable *strategy; //for hints, NULL without strategy.bin
+	struct player leaderboard[10]; //top 10 as of the last title menu or score
+	long ranked;
+	unsigned long long seed;
+	long started; //sessions so far, each gets its own random stream
+	int decks, penetration; //for new games
+	int promptLines; //end every reply with a line like "BET $1-$10> ", for clients reading off a socket
+};
+
+struct session{ //one player: where they are in the menus and their game
+	enum sessionStepEnum step;
+	struct sessionHost *host;
+	struct game game;
+};
+
+//a session between lines, packed down for hosting lots of them: unpacked into a struct session to handle a line
+//the shoe only keeps how many of each card have been dealt since the last reshuffle, the rest are drawn at random anyway
+struct sessionPacked{
+	struct rng rng;
+	char name[16];
+	long score, money;
+	int handNumber;
+	short roundResult;
+	unsigned short drawPosition, cut;
+	unsigned char step, gameState, decks, initialBet, totalBet;
+	signed char firstBuy;
+	unsigned char playerCards[TRICK_MAX], dealerCards[TRICK_MAX];
+	unsigned char dealt[26]; //4 bits per card code, code 1 in the low half of dealt[0]
+};
+_Static_assert(sizeof(struct sessionPacked) <= 128, "a packed session is meant to fit in two cache lines");
+
+#define SLAB_PAGE_BYTES (1 << 20) //slab memory is mapped this much at a time
+#define BENCH_SESSIONS 1000000
+
+struct slab{ //fixed size objects cut from big mapped pages, freed ones are reused first, nothing is malloc'd per object
+	int objectSize;
+	char **pages;
+	int pageCount, pageCapacity;
+	char *next, *end; //the newest page's space not handed out yet, so untouched memory stays unmapped
+	void *freeList; //each freed object holds the next one in its first bytes
+	long live;
+};
+
+struct sessionEntry{ //one handle in a sessionCache, kept in memory even while its session is hibernated
+	struct sessionPacked *resident; //NULL while hibernated (or the handle is free)
+	int prev, next; //list of resident sessions, most recently used first, -1 at the ends; free handles chain through next
+	int lastUse; //sessionClock() seconds
+	int hibernated;
+};
+
+struct sessionCache{ //packed sessions by handle, the recently used in memory and the rest hibernated to a file
+	int fd; //handle h lives at h * sizeof(struct sessionPacked) while hibernated
+	char path[JOURNAL_PATH_MAX];
+	struct slab slab; //the resident ones
+	struct sessionEntry *entries;
+	int count, capacity;
+	int head, tail, freeHandles;
+	long resident, maxResident;
+	int idleSeconds; //0 leaves idle sessions in memory until the ceiling needs the room
+	long hibernations, loads;
+};
+
+struct serverSession{ //one connection: its session's handle, the line coming in and any reply the socket couldn't take yet
+	int handle; //in the server's sessionCache
+	int done; //the session said goodbye, close once the reply is out
+	int fd;
+	int watching; //EPOLLIN or EPOLLOUT
+	char in[SESSION_LINE];
+	int inLength;
+	char *pending; //NULL unless the last reply didn't fit in the socket buffer
+	int pendingLength, pendingSent;
+	struct serverSession *prev, *next; //every open session, to save them all on the way out
+};
+
+struct server{
+	int listenFd, epollFd;
+	struct serverSession *sessions;
+	long open;
+	struct slab slab; //the serverSessions
+	struct sessionCache cache; //their packed sessions
+	struct session working; //the one unpacked session, the loop handles one line at a time
+	struct sessionHost host;
+	struct profileStore profiles;
+	struct rankShared board;
+};
+
+struct loadConnection{
+	int fd;
+	int id, generation; //player name, a new one for each game
+	double sent; //when the last line went, 0 before the first reply
+	char in[LOAD_REPLY + 1];
+	int inLength;
+};
+
+struct loadWorker{ //one load generator thread and its connections
+	pthread_t thread;
+	const char *address;
+	int id, sessions;
+	long actions, done;
+	float *latencies; //microseconds, one per action
+	struct rng rng;
+	int failed;
+};
+
+enum playerActionEnum {BUY = 1, TWIST, STICK, SAVE_QUIT}; //player turn menu options
+enum decisionEnum {DECIDE_BET = 1, DECIDE_ACTION, DECIDE_BUY}; //decisions a policy is asked to make
+
+//what happened on a state transition, so the caller can tell the player (or ignore it)
+enum roundEventEnum {EVENT_NONE = 0, EVENT_BOTH_BLACKJACK, EVENT_DEALER_BLACKJACK, EVENT_PLAYER_BLACKJACK, 
+	EVENT_PLAYER_FIVE_CARD_TRICK, EVENT_PLAYER_TWENTYONE, EVENT_PLAYER_BUST, EVENT_DEALER_STICKS, EVENT_DEALER_DRAWS,
+	EVENT_DEALER_BUST, EVENT_BLACKJACK_BEATS_TRICK, EVENT_TRICK_BEATS_TRICK, EVENT_TRICK_BEATS_HAND, 
+	EVENT_BLACKJACK_WINS, EVENT_TRICK_WINS, EVENT_HAND_WINS, EVENT_DEALER_WINS};
+
+//player policy for headless play: returns a bet, an action (enum playerActionEnum) or a buy amount between lower and upper
+typedef int (*playerPolicy)(const struct game *g, enum decisionEnum decision, int lower, int upper, void *context);
+
 //reading card king/suit string from struct->enum
 const char* cardKind(struct card);
 const char* cardSuit(struct card);
 
+//packing/unpacking cards, lookups into tables indexed by the card's code
+struct card cardMake(int suit, int kind); //anything out of range makes an empty slot
+enum suitEnum cardSuitOf(struct card cardIn); //0 for an empty slot
+enum kindEnum cardKindOf(struct card cardIn);
+int cardPoints(struct card cardIn); //ace is 1, pictures are 10
+
 //deck maniuplation functions
 void deckDisplay(struct card *deck); //only used for debugging
 void deckPopulate(struct card deck[52]); //populates deck with unshuffled cards
-void deckShuffle(struct card *deck); //fisher yates shuffle (see https://en.wikipedia.org/wiki/Fisher%E2%80%93Yates_shuffle)
-void resetCards(struct card *deck, struct card *playerHand, struct card *dealerHand); //empties hands, reshuffles deck 
+void deckShuffle(struct card *deck, struct rng *rng); //whole deck fisher yates shuffle (see https://en.wikipedia.org/wiki/Fisher%E2%80%93Yates_shuffle)
+struct card deckDraw(struct card *deck, int *position, struct rng *rng); //one fisher yates step, the deck is only shuffled as far as it's drawn
+void resetCards(struct hand *playerHand, struct hand *dealerHand); //empties hands
+void shoeFill(struct shoe *shoe, int decks, int penetration); //decks (1 to SHOE_MAX_DECKS) unshuffled, cut card penetration% in
+struct card shoeDraw(struct shoe *shoe, int *position, struct rng *rng); //deckDraw over the whole shoe
+int shoeCutReached(const struct shoe *shoe, int position); //time to reshuffle before the next round
+
+//random numbers, everything random goes through these so the generator can be swapped in one place
+void rngSeed(struct rng *rng, unsigned long long seed, unsigned long long stream); //stream picks an independent sequence for the same seed
+unsigned long long rngNext(struct rng *rng);
+int rngBelow(struct rng *rng, int n); //random int between 0 and n-1, no modulo bias
+void rngJump(struct rng *rng); //skips 2^128 draws ahead, for splitting one stream between threads
+int rngSelfTest(long shuffles, int threads, unsigned long long seed); //--rng-selftest N, chi-square on shuffles
+static double wallSeconds(); //wall clock in seconds, for timings
 
 //display hand functions
-void displayFirstCard(struct card hand[5]); //for first round with dealer
-void displayHand(struct card *hand);
-void topDraw(struct card *hand, struct card *deck, int *position);
+void displayFirstCard(const struct hand *hand); //for first round with dealer
+void displayHand(const struct hand *hand);
+void displayTable(const struct game *g, int showDealer); //clears screen, prints header and both hands
+void displayHands(const struct game *g, int showDealer); //the table under the header: shoe and both hands
+void topDraw(struct hand *hand, struct shoe *shoe, int *position, struct rng *rng);
 
 //calculating details of dealer/player hand
-int handValue(struct card *hand);
-int handSize(struct card *hand);
-enum handRankingEnum handResolve(struct card *hand); //returns the ranking of hand (blackjack, bust, etc)
+//all O(1), they only read the totals handAdd keeps
+int handValue(const struct hand *hand);
+int handSize(const struct hand *hand);
+enum handRankingEnum handResolve(const struct hand *hand); //returns the ranking of hand (blackjack, bust, etc)
+void handEmpty(struct hand *hand);
+void handAdd(struct hand *hand, struct card card); //adds a card and updates size/totals
+void handRecount(struct hand *hand); //rebuilds size/totals from the cards (after loading)
+void handBatchResolve(struct handBatch *batch); //handValue and handResolve for a whole batch, avx2/sse2 when compiled in
+void handBatchResolveScalar(struct handBatch *batch); //same, one hand at a time
+int benchEvaluate(long hands, unsigned long long seed); //--bench-eval [N], batch vs per hand scoring
+
+//exact dealer odds (replaces simulating the dealer for EV questions)
+int cardRank(struct card cardIn); //index into struct deckCounts
+void deckCountsFull(struct deckCounts *counts, int decks);
+void deckCountsRemove(struct deckCounts *counts, struct card cardIn);
+void deckCountsFromDeck(struct deckCounts *counts, const struct card *deck, int from, int to);
+void dealerCacheInit(struct dealerCache *cache);
+void dealerCacheFree(struct dealerCache *cache);
+void dealerOutcomeOdds(struct dealerCache *cache, const struct hand *dealer, const struct deckCounts *remaining, struct dealerOdds *odds);
+int printDealerOdds(); //--dealer-odds
+
+//optimal BUY/TWIST/STICK strategy, solved from the exact dealer odds and saved as strategy.bin
+int strategyHandIndex(const unsigned char *held); //player's cards by rank -> table index, -1 if not 1-4 cards
+int solveStrategy(const char *path, int threads); //--solve
+int strategyLoad(struct strategyTable *table, const char *path); //1 if loaded
+enum strategyActionEnum strategyLookup(const struct strategyTable *table, const struct game *g, int *ev);
+int policyStrategy(const struct game *g, enum decisionEnum decision, int lower, int upper, void *context); //context is the table
 
 ////functions to save/load////
+//save.bin is read once at startup (and again only if something else changes it) and written once per save
+int readSave(struct saveFile *save, const char *path); //0 if there's no file
+int validFile(const struct saveFile *save); //header, version and crc
+void sealSave(struct saveFile *save); //fills in the header and crc
+int writeSave(struct saveFile *save, const char *path); //seals it, then temp file + rename
+int migrateSave(struct saveFile *save); //save.txt -> save.bin, or an empty save if neither exists
+int saveCacheRefresh(struct saveCache *cache, const char *path); //a stat, plus a read if the file changed, 0 if there's no file
+int saveCacheWrite(struct saveCache *cache, const char *path);
+int benchMenu(long passes); //--bench-menu [N], title menu save handling: text vs binary vs cached
+
+//save.bin.journal: one small record per finished hand, replayed on top of save.bin when it's loaded
+int journalReset(struct journal *journal, const char *savePath, unsigned int saveCrc); //empty journal for that snapshot
+long journalAppend(struct journal *journal, struct player player, struct gameVars vars); //records so far, -1 on error
+void journalClose(struct journal *journal);
+long journalReplay(struct saveFile *save, const char *savePath); //records applied to save
+int saveCacheRecord(struct saveCache *cache, const char *path, struct player player, struct gameVars vars); //journals a hand, 1 when it's time to compact
+void saveCacheClose(struct saveCache *cache, const char *path); //waits for background writes, stops the writer
+int benchJournal(long hands); //--bench-journal [N], rewriting the save every hand vs journaling vs the background writer
+
+//profile store: every player's saved game in one memory-mapped file, found by hashing their name
+int profileStoreOpen(struct profileStore *store, const char *path); //creates an empty store if there isn't one
+void profileStoreClose(struct profileStore *store);
+int profileSave(struct profileStore *store, const struct game *g); //under g's player name, replacing any old one
+int profileLoad(struct profileStore *store, const char *name, struct game *g); //1 loaded, 0 no profile, -1 damaged
+int profileRemove(struct profileStore *store, const char *name);
+long profileList(struct profileStore *store, char names[][PROFILE_NAME], int max, int *listed); //returns the total
+int benchProfiles(long profiles); //--bench-profiles [N]
+
+//ranked leaderboard: everyone who ever played, the top 10 screen is just the first page of it
+void rankInit(struct rankBoard *board); //an empty board only kept in memory
+void rankFree(struct rankBoard *board);
+int rankLoad(struct rankBoard *board, const char *path); //leaderboard.db plus its log, 0 if neither exists yet
+int rankSave(struct rankBoard *board); //rewrites leaderboard.db and empties the log
+int rankSubmit(struct rankBoard *board, struct player player); //keeps each name's best score, 1 if it changed
+int rankLogSubmit(struct rankBoard *board, const struct player *players, long count); //makes submissions survive a restart
+long rankOf(const struct rankBoard *board, const char *name); //1 is the top, 0 not ranked
+int rankRange(const struct rankBoard *board, long first, struct player *out, int k);
+int benchLeaderboard(long players, int threads); //--bench-leaderboard [N] [--threads T]
+
+//the board shared between sessions: submissions are buffered in shards and merged in batches, the top is read from a snapshot
+int rankSharedOpen(struct rankShared *shared, const char *path, int mergeMs);
+void rankSharedClose(struct rankShared *shared);
+void rankSharedSubmit(struct rankShared *shared, struct player player); //any thread
+void rankSharedMerge(struct rankShared *shared); //only writes to disk itself when there's no merge thread
+int rankSharedTop(struct rankShared *shared, struct player *out, int k, long *count); //any thread, lock free
+long rankSharedRankOf(struct rankShared *shared, const char *name);
+
+//background saves
+int saveWriterStart(struct saveWriter *writer, const char *path); //0 if the thread couldn't be started
+void saveWriterSubmit(struct saveWriter *writer, const struct saveFile *save); //copies save and returns
+void saveWriterFlush(struct saveWriter *writer);
+void saveWriterStop(struct saveWriter *writer); //finishes anything pending first
+unsigned int crc32(const void *data, long length);
+
 //only when user chooses "LOAD GAME"
-void loadGame(FILE **fIO, struct player *leaderboard, struct player *currentPlayer, struct card *deck, struct card *playerHand, struct card *dealerHand, struct gameVars *loadVars);
-int validFile(FILE **fIO);
+void loadGame(const struct saveFile *save, struct player *leaderboard, struct player *currentPlayer, struct shoe *shoe, struct hand *playerHand, struct hand *dealerHand, struct gameVars *loadVars);
 
 //called at the start in case player starts new game, only leaderboard carries over
-void loadLeaderboard(FILE **fIO, struct player *leaderboard); 
-void saveGame(FILE **fIO, struct player *leaderboard, struct player currentPlayer, struct card *deck, struct card *playerHand, struct card *dealerHand, struct gameVars saveVars);
+long loadLeaderboard(struct rankShared *board, const struct saveFile *save, struct player *leaderboard); //returns players ranked
+int saveGame(struct saveCache *cache, struct player *leaderboard, struct player currentPlayer, struct shoe *shoe, struct hand *playerHand, struct hand *dealerHand, struct gameVars saveVars);
+
+//info screens from the title menu
+void displayInfo(int page);
+
+//sessions: a player's way through the title menu and the game, moved on one line of input at a time
+void sessionStart(struct session *s, struct sessionHost *host); //title menu, the reply is left in the frame
+void sessionInput(struct session *s, const char *line); //runs up to the next question, the reply is left in the frame
+int sessionPlaying(enum sessionStepEnum step); //a game is underway that a dropped session should keep
+void sessionPack(const struct session *s, struct sessionPacked *packed);
+void sessionUnpack(const struct sessionPacked *packed, struct sessionHost *host, struct session *s);
+int benchSessions(long count); //--bench-sessions [N], memory and allocation rate of N live sessions
+
+//slab allocator for objects of one size
+void slabInit(struct slab *slab, int objectSize);
+void *slabAlloc(struct slab *slab); //NULL when out of memory
+void slabFree(struct slab *slab, void *object);
+void slabDestroy(struct slab *slab); //unmaps every page
+
+//packed sessions past a memory ceiling or an idle timeout hibernate to a file, and are read back on their next line
+int sessionCacheOpen(struct sessionCache *cache, const char *path, long maxResident, int idleSeconds); //0 if the file can't be made
+void sessionCacheClose(struct sessionCache *cache); //removes the file
+int sessionCacheAdd(struct sessionCache *cache, const struct sessionPacked *packed); //its handle, -1 when out of memory
+struct sessionPacked *sessionCacheGet(struct sessionCache *cache, int handle); //NULL if it couldn't be read back
+void sessionCacheRemove(struct sessionCache *cache, int handle);
+void sessionCacheSweep(struct sessionCache *cache); //hibernates the sessions idle past the timeout
+int benchHibernate(long count, unsigned long long seed); //--bench-hibernate [N], N sessions with a tenth of them in memory
+
+////headless game engine////
+//one function per gameState transition, none of them read input or print anything
+void gameNew(struct game *g); //full bankroll, zero score, fresh shoe of g->decks (name is left alone)
+void gameDealFirst(struct game *g); //state 0: new round, one card each
+void gamePlaceBet(struct game *g, int bet); //state 0: initial bet, second cards dealt -> state 1
+enum roundEventEnum gameCheckBlackjack(struct game *g); //state 1 -> 2, 3 or 6
+void gameBuyLimits(const struct game *g, int *lower, int *upper); //allowed buy range this turn
+void gameBuy(struct game *g, int amount); //state 2 -> 3
+void gameTwist(struct game *g); //state 2 -> 3
+void gameStick(struct game *g); //state 2 -> 4
+enum roundEventEnum gameResolvePlayer(struct game *g); //state 3 -> 2, 4 or 6
+int gameDealerMustDraw(const struct game *g); //dealer draws below 17
+enum roundEventEnum gameDealerTurn(struct game *g); //state 4: one dealer stick or draw, -> 5 when done
+enum roundEventEnum gameSettle(struct game *g); //state 5 -> 6, pays out roundResult
+int gameIsOver(const struct game *g); //state 6: out of money
+long gamePlayRound(struct game *g, playerPolicy policy, void *context); //plays states 0-6 under a policy, returns roundResult
 
-//title menu function
-int titleMenu();
-void displayInfo();
+//tables: the same round with every seat playing against one dealer hand, the dealer plays once for all of them
+void tableNew(struct table *t, int seats, int decks, int penetration); //full bankroll at every seat, fresh shoe (names are left alone)
+void tableDealFirst(struct table *t); //state 0: new round, one card to each seat then the dealer
+void tablePlaceBet(struct table *t, int seat, int bet); //state 0: once every seat has bet, second cards and blackjacks -> 2, 4 or 6
+void tableBuy(struct table *t, int amount); //state 2 -> 3: for the seat whose turn it is, within gameBuyLimits of its view
+void tableTwist(struct table *t); //state 2 -> 3
+void tableStick(struct table *t); //state 2: the next seat's turn, or the dealer's after the last seat
+void tableResolveSeat(struct table *t); //state 3 -> 2 for the same seat, or on to the next as tableStick
+void tableDealerPlay(struct table *t); //state 4 -> 5: the dealer's whole hand
+void tableSettle(struct table *t); //state 5 -> 6, every seat still in is paid out
+const struct game *tableView(struct table *t, int seat); //the seat as a game, for policies and display
+long tablePlayRound(struct table *t, playerPolicy policy, void *context); //a round with every seat under the policy, returns their total result
 
-//sets up a new game (assign variables etc)
-void newGame(struct card *deck, struct card *playerHand, struct card *dealerHand, struct player *currentPlayer);
+//house rule variants
+//the rule-dependent engine steps are written once as inline functions taking the rules as plain ints (RULES_PARAMS),
+//the game* functions above pass them HOUSE_RULES, and RULE_VARIANTS stamps out one round function per variant
+//with its rules as constants, so the compiler folds every rule check away and the simulation picks one at runtime
+#if defined(__GNUC__)
+#define RULES_INLINE static inline __attribute__((always_inline))
+#else
+#define RULES_INLINE static inline
+#endif
+#define RULES_PARAMS int trickCards, int hitSoft17, int blackjackPays, int trickPays
+#define RULES_ARGS trickCards, hitSoft17, blackjackPays, trickPays
+#define HOUSE_RULES 5, 0, 2, 2 //five card trick, dealer stands on soft 17, blackjack and trick pay twice the bet
+
+//X(id, name, trick cards, dealer hits soft 17, blackjack pays, trick pays, description)
+#define RULE_VARIANTS(X) \
+	X(house, "house", 5, 0, 2, 2, "five card trick, dealer stands on soft 17, blackjack and trick pay 2x") \
+	X(sixTrick, "six-trick", 6, 0, 2, 2, "tricks need six cards") \
+	X(hitSoft17, "h17", 5, 1, 2, 2, "dealer hits soft 17") \
+	X(sixTrickH17, "six-trick-h17", 6, 1, 2, 2, "six card trick and dealer hits soft 17") \
+	X(evens, "evens", 5, 0, 1, 1, "blackjack and trick pay evens") \
+	X(triple, "triple", 5, 0, 3, 3, "blackjack and trick pay 3x")
+
+struct rules{ //one house rule variant and its specialized round
+	const char *name;
+	int trickCards; //hand size that makes a trick
+	int hitSoft17; //dealer draws on soft 17 as well
+	int blackjackPays; //multiples of the bet
+	int trickPays;
+	const char *description;
+	long (*playRound)(struct game *g, playerPolicy policy, void *context); //gamePlayRound under these rules
+	long (*playTableRound)(struct table *t, playerPolicy policy, void *context); //tablePlayRound under these rules
+};
+
+RULES_INLINE enum handRankingEnum rulesResolve(const struct hand *hand, RULES_PARAMS);
+RULES_INLINE enum roundEventEnum rulesCheckBlackjack(struct game *g, RULES_PARAMS);
+RULES_INLINE enum roundEventEnum rulesResolvePlayer(struct game *g, RULES_PARAMS);
+RULES_INLINE int rulesDealerMustDraw(const struct hand *dealer, RULES_PARAMS);
+RULES_INLINE enum roundEventEnum rulesDealerTurn(struct game *g, RULES_PARAMS);
+RULES_INLINE enum roundEventEnum rulesSettle(struct game *g, RULES_PARAMS);
+RULES_INLINE enum roundEventEnum rulesPayout(const struct hand *player, const struct hand *dealer, long bet, long *result, RULES_PARAMS);
+RULES_INLINE long rulesPlayRound(struct game *g, playerPolicy policy, void *context, RULES_PARAMS);
+RULES_INLINE void rulesTablePlaceBet(struct table *t, int seat, int bet, RULES_PARAMS);
+RULES_INLINE void rulesTableResolveSeat(struct table *t, RULES_PARAMS);
+RULES_INLINE void rulesTableDealerPlay(struct table *t, RULES_PARAMS);
+RULES_INLINE void rulesTableSettle(struct table *t, RULES_PARAMS);
+RULES_INLINE long rulesTablePlayRound(struct table *t, playerPolicy policy, void *context, RULES_PARAMS);
+const struct rules *rulesFind(const char *name); //runtime dispatch: the variant called name, NULL if there isn't one
+void rulesList(); //prints every variant
+
+//batch play
+int policyMimicDealer(const struct game *g, enum decisionEnum decision, int lower, int upper, void *context); //min bets, twists below 17
+int simulate(long hands, int threads, unsigned long long seed, const struct rules *rules, playerPolicy policy, void *context,
+	int seats, int decks, int penetration); //--simulate N [--threads T] [--seed S] [--rules R] [--seats S], N rounds at a table of S > 1
+long simPlayHand(struct game *g, unsigned long long seed, long hand, const struct rules *rules, playerPolicy policy, void *context); //plays simulated hand number "hand" of a run
+void simTableStart(struct table *t, unsigned long long seed, long batch, int seats, int decks, int penetration); //the table a batch of rounds is played at
+int replayHand(long hand, unsigned long long seed, const struct rules *rules, playerPolicy policy, void *context,
+	int seats, int decks, int penetration); //--replay K, shows hand (or round) K of a --simulate run
+int benchTable(long hands, int decks, int penetration, unsigned long long seed); //--bench-table [N], fresh shoe per hand vs tables of 1 to TABLE_SEATS seats
 
 /////quality of life functions////
+	//screen output is built up as a frame and sent when input is needed, see screenFlush
+void screenClear(); //starts a new frame (instead of system("cls"))
+void screenPrintf(const char *format, ...);
+void screenFlush(); //one write, only the changed lines on a terminal; the input functions call it before reading
+void screenWrite(const char *text, int length); //the writers below append as is, nothing is read as a format
+#define SCREEN_LITERAL(text) screenWrite("" text, sizeof(text) - 1) //string literals only (the "" won't compile otherwise), length known at compile time
+void screenString(const char *text);
+void screenLong(long n);
+void screenCard(struct card cardIn); //"ACE of SPADES", from a table
+void displaySettlement(const struct game *g, enum roundEventEnum result); //state 5's message, after gameSettle
+int benchRender(long rounds); //--bench-render [N]
 	//art of https://patorjk.com/software/taag
 void printArt();
 void printGameOver();
 void printHeader(const char *playerName, int handNumber, long money, int initialBet, int totalBet, long score);
+void printStatus(const char *playerName, int handNumber, long money, int initialBet, int totalBet, long score); //the header's line under the art
 void printHighScore();
-void enterToContinue(); //simple press enter to continue function
 
 //swapping functions via pointers
 void swapCard(struct card *i,struct card *j); //swap card used in shuffle
-void swapPlayer(struct player *i, struct player *j); //swaping players during bubble sort
 
-//functions for getting numeric input 
-int multiDigitInput(int lowerLimit, int upperLimit);
-int singleDigitInput(char lowerLimit, char upperLimit);
+//reading input
+int readLine(char *line, int size); //flushes the frame first, 0 at the end of input
 
 
 // leaderboard functions
 void resetLeaderboard(struct player *leaderboard); // initializing leaderboard array prior to filling
-void updateLeaderboard(struct player *leaderboard, struct player currentPlayer); //updates leaderboard 
+long updateLeaderboard(struct rankShared *board, struct player *leaderboard, struct player currentPlayer, int mergeNow); //submits to the board, refreshes the top 10
+	//mergeNow merges even with a merge thread running, so the player's own rank is already in
+
+//game server and its load generator
+int serverAddress(const char *address, int listening, struct sockaddr_storage *addr, socklen_t *length); //port, host:port or Unix socket path
+int serve(const char *address, unsigned long long seed, int decks, int penetration, int idleSeconds, long memoryMB); //--serve ADDR
+int loadServer(const char *address, long actions, int sessions, int threads, unsigned long long seed); //--load ADDR [N], p50/p99 per action
+
+//for options with an optional count after them: uses the next argument if it's a number, else the fallback
+static long optionalCount(int argc, char *argv[], int *i, long fallback){
+	if (*i+1 < argc && argv[*i+1][0] >= '0' && argv[*i+1][0] <= '9')
+		return atol(argv[++*i]);
+	return fallback;
+}
 
-int main(){
+int main(int argc, char *argv[]){
 
-	srand(time(NULL)); //randomize seed
+	//command line options
+	long simulateHands = 0;
+	long replay = 0;
+	long selfTest = 0;
+	long benchEval = 0;
+	long benchMenuPasses = 0;
+	long benchJournalHands = 0;
+	long benchProfileCount = 0;
+	long benchRankCount = 0;
+	long benchRenderRounds = 0;
+	long benchSessionCount = 0;
+	long benchHibernateCount = 0;
+	long benchTableHands = 0;
+	int seats = 0; //--simulate/--replay at a table, 0 deals each hand from a fresh one-deck shoe
+	int shoeGiven = 0;
+	const char *serveAddress = NULL;
+	const char *loadAddress = NULL;
+	long loadActions = 0;
+	int sessions = LOAD_SESSIONS;
+	int idleSeconds = SESSION_IDLE_SECONDS;
+	long sessionMemory = SESSION_MEMORY_MB;
+	int dealerOddsTable = 0;
+	int solve = 0;
+	playerPolicy policy = policyMimicDealer;
+	const struct rules *rules = rulesFind("house");
+	struct strategyTable *strategy = malloc(sizeof(struct strategyTable));
+	int haveStrategy = strategy != NULL && strategyLoad(strategy, "strategy.bin"); //for hints and --policy strategy
+	int threads = 1;
+	int decks = SHOE_DECKS, penetration = SHOE_PENETRATION; //shoe for new games
+	unsigned long long seed = time(NULL); //randomize seed
+	for (int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "--simulate") == 0 && i+1 < argc){
+			simulateHands = atol(argv[++i]);
+		} else if (strcmp(argv[i], "--replay") == 0 && i+1 < argc){
+			replay = atol(argv[++i]);
+		} else if (strcmp(argv[i], "--rng-selftest") == 0){
+			selfTest = optionalCount(argc, argv, &i, 100000000); //10^8 shuffles unless a count follows
+		} else if (strcmp(argv[i], "--bench-eval") == 0){
+			benchEval = optionalCount(argc, argv, &i, 100000000);
+		} else if (strcmp(argv[i], "--bench-menu") == 0){
+			benchMenuPasses = optionalCount(argc, argv, &i, 100000);
+		} else if (strcmp(argv[i], "--bench-journal") == 0){
+			benchJournalHands = optionalCount(argc, argv, &i, 1000);
+		} else if (strcmp(argv[i], "--bench-profiles") == 0){
+			benchProfileCount = optionalCount(argc, argv, &i, 1000000);
+		} else if (strcmp(argv[i], "--bench-leaderboard") == 0){
+			benchRankCount = optionalCount(argc, argv, &i, 1000000);
+		} else if (strcmp(argv[i], "--bench-render") == 0){
+			benchRenderRounds = optionalCount(argc, argv, &i, 1000000);
+		} else if (strcmp(argv[i], "--bench-sessions") == 0){
+			benchSessionCount = optionalCount(argc, argv, &i, BENCH_SESSIONS);
+		} else if (strcmp(argv[i], "--bench-table") == 0){
+			benchTableHands = optionalCount(argc, argv, &i, 10000000);
+		} else if (strcmp(argv[i], "--seats") == 0 && i+1 < argc){
+			seats = atoi(argv[++i]);
+			if (seats < 1 || seats > TABLE_SEATS){
+				printf("ERROR: --seats must be between 1 and %d\n", TABLE_SEATS);
+				return(1);
+			}
+		} else if (strcmp(argv[i], "--bench-hibernate") == 0){
+			benchHibernateCount = optionalCount(argc, argv, &i, BENCH_SESSIONS);
+		} else if (strcmp(argv[i], "--serve") == 0 && i+1 < argc){
+			serveAddress = argv[++i];
+		} else if (strcmp(argv[i], "--load") == 0 && i+1 < argc){
+			loadAddress = argv[++i];
+			loadActions = optionalCount(argc, argv, &i, LOAD_ACTIONS);
+		} else if (strcmp(argv[i], "--sessions") == 0 && i+1 < argc){
+			sessions = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--idle-seconds") == 0 && i+1 < argc){
+			idleSeconds = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--session-memory") == 0 && i+1 < argc){
+			sessionMemory = atol(argv[++i]);
+			if (sessionMemory < 1){
+				printf("ERROR: --session-memory is in MB, at least 1\n");
+				return(1);
+			}
+		} else if (strcmp(argv[i], "--dealer-odds") == 0){
+			dealerOddsTable = 1;
+		} else if (strcmp(argv[i], "--rules") == 0 && i+1 < argc){
+			rules = rulesFind(argv[++i]);
+			if (rules == NULL){
+				printf("ERROR: no rules called \"%s\", the variants are:\n", argv[i]);
+				rulesList();
+				return(1);
+			}
+		} else if (strcmp(argv[i], "--solve") == 0){
+			solve = 1;
+		} else if (strcmp(argv[i], "--policy") == 0 && i+1 < argc && strcmp(argv[i+1], "dealer") == 0){
+			policy = policyMimicDealer;
+			i++;
+		} else if (strcmp(argv[i], "--policy") == 0 && i+1 < argc && strcmp(argv[i+1], "strategy") == 0){
+			if (!haveStrategy){
+				printf("ERROR: --policy strategy needs strategy.bin, run --solve first\n");
+				return(1);
+			}
+			policy = policyStrategy;
+			i++;
+		} else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc){
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc){
+			seed = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--decks") == 0 && i+1 < argc){
+			decks = atoi(argv[++i]);
+			shoeGiven = 1;
+			if (decks < 1 || decks > SHOE_MAX_DECKS){
+				printf("ERROR: --decks must be between 1 and %d\n", SHOE_MAX_DECKS);
+				return(1);
+			}
+		} else if (strcmp(argv[i], "--penetration") == 0 && i+1 < argc){
+			penetration = atoi(argv[++i]);
+			shoeGiven = 1;
+			if (penetration < 1 || penetration > 100){
+				printf("ERROR: --penetration is a percentage of the shoe, 1 to 100\n");
+				return(1);
+			}
+		} else{
+			printf("usage: %s [--simulate N | --replay K | --rng-selftest [N] | --bench-eval [N] | --bench-menu [N] | --bench-journal [N] | --bench-profiles [N]\n       | --bench-leaderboard [N] | --bench-render [N] | --bench-sessions [N] | --bench-hibernate [N]\n       | --bench-table [N] | --dealer-odds | --solve | --serve ADDR [--idle-seconds S] [--session-memory MB] | --load ADDR [N] [--sessions S]]\n       [--threads T] [--seed S] [--policy dealer|strategy] [--rules R]\n       [--decks D] [--penetration P] [--seats S]\n", argv[0]);
+			return(1);
+		}
+	}
 	
-	//initializing program variablles
-	int exitProgram = 0;
-	int exitGame = 1;
-	int titleChoice = 0;
-	int userInput = -1;
+	//headless batch play, skips the menus entirely
+	if (seats == 0 && shoeGiven)
+		seats = 1; //the shoe options only mean something when hands are dealt from one shoe in a row
+	if (simulateHands != 0){
+		return simulate(simulateHands, threads, seed, rules, policy, strategy, seats, decks, penetration);
+	}
+	if (replay != 0){
+		return replayHand(replay, seed, rules, policy, strategy, seats, decks, penetration);
+	}
+	if (selfTest != 0){
+		return rngSelfTest(selfTest, threads, seed);
+	}
+	if (benchEval != 0){
+		return benchEvaluate(benchEval, seed);
+	}
+	if (benchMenuPasses != 0){
+		return benchMenu(benchMenuPasses);
+	}
+	if (benchJournalHands != 0){
+		return benchJournal(benchJournalHands);
+	}
+	if (benchProfileCount != 0){
+		return benchProfiles(benchProfileCount);
+	}
+	if (benchRankCount != 0){
+		return benchLeaderboard(benchRankCount, threads);
+	}
+	if (serveAddress != NULL){
+		return serve(serveAddress, seed, decks, penetration, idleSeconds, sessionMemory);
+	}
+	if (loadAddress != NULL){
+		return loadServer(loadAddress, loadActions, sessions, threads, seed);
+	}
+	if (benchSessionCount != 0){
+		return benchSessions(benchSessionCount);
+	}
+	if (benchTableHands != 0){
+		return benchTable(benchTableHands, decks, penetration, seed);
+	}
+	if (benchHibernateCount != 0){
+		return benchHibernate(benchHibernateCount, seed);
+	}
+	if (benchRenderRounds != 0){
+		return benchRender(benchRenderRounds);
+	}
+	if (dealerOddsTable){
+		return printDealerOdds();
+	}
+	if (solve){
+		return solveStrategy("strategy.bin", threads);
+	}
 	
-	FILE *fIO; //file input
+	struct saveCache saveCache; //save.bin as last read or written
+	memset(&saveCache, 0, sizeof(saveCache));
+	saveCache.journal.fd = -1;
+	struct saveWriter saveWriter;
+	if (saveWriterStart(&saveWriter, SAVE_PATH)){
+		saveCache.writer = &saveWriter;
+	}
+	struct profileStore profiles; //everyone's saved games, save.bin keeps the leaderboard and the last game
+	int haveProfiles = profileStoreOpen(&profiles, PROFILE_PATH);
+	static struct rankShared rankBoard; //every player ranked, the leaderboard array is its top 10
+	rankSharedOpen(&rankBoard, RANK_PATH, 0); //one session, so it merges as soon as a score is in
 	
-	//game variables
-	struct player leaderboard[10];
-	struct player currentPlayer;
-	currentPlayer.score = 0;
-	struct card deck[52];
-	struct card playerHand[5];
-	struct card dealerHand[5];
-	struct gameVars gameVariables; //only used for saving/loading
-	long money = 0; 
-	int handNumber = 0;
-	int drawPosition = 0;
-	int initialBet = 0;
-	int totalBet = 0;
-	int firstBuy = 0;
-	int gameState = 0;
-	
-	//initializing leaderboard values
-	resetLeaderboard(leaderboard);
+	struct sessionHost host;
+	memset(&host, 0, sizeof(host));
+	host.saveCache = &saveCache;
+	host.profiles = haveProfiles ? &profiles : NULL;
+	host.board = &rankBoard;
+	host.strategy = haveStrategy ? strategy : NULL;
+	host.seed = seed;
+	host.decks = decks;
+	host.penetration = penetration;
 	
-	//main exit loop
-	while (!exitProgram){					// C7: LOOP TO START
-		
-		fIO = fopen("save.txt", "r"); //checking for file C3: FILE INPUT
-		if (fIO != NULL){
-		
-		
-		if (!validFile(&fIO)){ //checking save file has correct # of lines
-			printf("ERROR: \"save.txt\" LIKELY TAMPERED WITH\nABORTING PROGRAM\n");
-			enterToContinue();
-			return(1); //main returns 1(error)
+	//one session on stdin: the menus and the game all live in it, each line read moves it on
+	struct session session;
+	char line[SESSION_LINE];
+	sessionStart(&session, &host);
+	if (!haveProfiles){ //under the title menu, sessionStart starts the frame afresh
+		screenPrintf("ERROR: couldn't open \"%s\", LOAD GAME only has the last game\n", PROFILE_PATH);
+	}
+	while (session.step != STEP_DONE && session.step != STEP_ABORT && readLine(line, sizeof(line))){ // C7: LOOP
+		sessionInput(&session, line);
+	}
+
+	saveCacheClose(&saveCache, SAVE_PATH);
+	profileStoreClose(&profiles);
+	rankSharedClose(&rankBoard);
+	free(strategy);
+	if (session.step == STEP_ABORT){
+		screenFlush();
+		return(1); //main returns 1 (error)
+	}
+	screenPrintf("Thanks for playing!");
+	screenFlush();
+	return(0);	//main returns 0 (execution okay)
+} 
+
+////sessions////
+//a player's whole way through the program, title menu included, as a state machine: sessionInput takes one line,
+//runs everything up to the next question and leaves the reply in the frame, so nothing ever blocks waiting for input
+//the interactive game runs one of them on stdin, the server one per connection
+
+//the line that ends a reply on the server, so a client can tell the reply is complete and what it's being asked
+static void sessionPromptLine(const struct session *s){
+	int lower, upper;
+	switch (s->step){
+		case STEP_TITLE:
+			SCREEN_LITERAL("MENU> ");
+			break;
+		case STEP_NAME:
+			SCREEN_LITERAL("NAME> ");
+			break;
+		case STEP_PROFILE:
+			SCREEN_LITERAL("PROFILE> ");
+			break;
+		case STEP_BET:
+			SCREEN_LITERAL("BET $1-$10> ");
+			break;
+		case STEP_ACTION:
+			SCREEN_LITERAL("ACTION> ");
+			break;
+		case STEP_BUY:
+			gameBuyLimits(&s->game, &lower, &upper);
+			SCREEN_LITERAL("BUY $");
+			screenLong(lower);
+			SCREEN_LITERAL("-$");
+			screenLong(upper);
+			SCREEN_LITERAL("> ");
+			break;
+		case STEP_AGAIN:
+			SCREEN_LITERAL("AGAIN> ");
+			break;
+		case STEP_CONTINUE:
+		case STEP_INFO:
+		case STEP_BACK:
+			SCREEN_LITERAL("ENTER> ");
+			break;
+		default: //done, nothing more is asked
+			break;
+	}
+}
+
+//menus take a plain number (no sign, no spaces), -1 for anything else
+static int sessionNumber(const char *line, int lower, int upper){
+	int length = strlen(line);
+	if (length == 0 || length > 9 || strspn(line, "0123456789") != (size_t)length)
+		return -1;
+	int n = atoi(line);
+	return n >= lower && n <= upper ? n : -1;
+}
+
+//"Press ENTER to continue", the game carries on with the next line whatever it is
+static void sessionPause(struct session *s, enum sessionStepEnum step){
+	SCREEN_LITERAL("Press ENTER to continue\n");
+	s->step = step;
+}
+
+//back to the title menu, save.bin is checked for changes first (interactive) and the leaderboard reloaded
+static void sessionTitle(struct session *s){
+	struct sessionHost *host = s->host;
+	if (host->saveCache != NULL){
+		int haveSave = saveCacheRefresh(host->saveCache, SAVE_PATH); //checking for file C3: FILE INPUT
+		if (!haveSave && migrateSave(&host->saveCache->save)){
+			haveSave = saveCacheRefresh(host->saveCache, SAVE_PATH);
 		}
-		
-		//loading leaderboard
-		loadLeaderboard(&fIO, leaderboard);
-		
-		//title menu stuff
-		titleChoice = titleMenu();
-		switch (titleChoice){ 				// C1: SELECTION 
-			case 1: //new game
-
-				//newgame variable assignment
-				currentPlayer.score = 0;
-				handNumber = 0;
-				money = 100;
-				exitGame = 0;
-				gameState = 0; 
-				newGame(deck, playerHand, dealerHand, &currentPlayer); //setting up deck, hands, score
-				break;
-			case 2: //load game
-				
-				//loading game variables
-				loadGame(&fIO, leaderboard, &currentPlayer, deck, playerHand, dealerHand, &gameVariables);
-				
-				if (gameVariables.money <= 0){ //if old save money < 0, starts new game instead
-					//newgame variable assignment
-					currentPlayer.score = 0;
-					handNumber = 0;
-					money = 100;
-					exitGame = 0;
-					gameState = 0; 
-					newGame(deck, playerHand, dealerHand, &currentPlayer); //setting up deck, hands, score
-				} else{
-					//otherwise loads game variables from gameVariable struct
-					drawPosition = gameVariables.drawPosition;	
-					firstBuy = gameVariables.firstBuy;
-					gameState = gameVariables.gameState;
-					handNumber = gameVariables.handNumber;
-					initialBet = gameVariables.initialBet;
-					money = gameVariables.money;
-					totalBet = gameVariables.totalBet;
-					exitGame = 0;
+		if (!haveSave){
+			screenPrintf("\nERROR: no usable \"%s\" or \"%s\". Aborting program.\n", SAVE_PATH, SAVE_TEXT_PATH);
+			s->step = STEP_ABORT;
+			return;
+		}
+		if (!host->saveCache->valid){ //checking header and checksum
+			screenPrintf("ERROR: \"%s\" LIKELY TAMPERED WITH\nABORTING PROGRAM\n", SAVE_PATH);
+			s->step = STEP_ABORT;
+			return;
+		}
+		host->ranked = loadLeaderboard(host->board, &host->saveCache->save, host->leaderboard);
+	} else{
+		resetLeaderboard(host->leaderboard);
+		rankSharedTop(host->board, host->leaderboard, 10, &host->ranked);
+	}
+	
+	screenClear();
+	printArt();
+	screenPrintf("Please enter the number corresponding to your selection\n[1] NEW GAME\n[2] LOAD GAME\n[3] LEADERBOARD\n[4] INFO\n[5] QUIT\n");
+	s->step = STEP_TITLE;
+}
+
+//save and quit: the leaderboard, save.bin (interactive) and the player's profile
+static void sessionSaveQuit(struct session *s){
+	struct sessionHost *host = s->host;
+	struct game *g = &s->game;
+	host->ranked = updateLeaderboard(host->board, host->leaderboard, g->player, 0); //updating leaderboard(current player goes in if elegible)
+	if (host->saveCache != NULL)
+		saveGame(host->saveCache, host->leaderboard, g->player, &g->shoe, &g->playerHand, &g->dealerHand, g->vars);
+	if (host->profiles != NULL)
+		profileSave(host->profiles, g);
+	sessionTitle(s);
+}
+
+//a round has just been settled (state 6): it's kept before the result is even shown, so quitting at the result can't undo it
+//interactive: the hand goes in the journal, save.bin is only rewritten every JOURNAL_COMPACT hands
+//both: the profile is kept too (one slot), so LOAD GAME by name never finds an older copy than save.bin's
+//game over: the score goes on the leaderboard and the finished game's profile is freed
+static void sessionRoundOver(struct session *s){
+	struct sessionHost *host = s->host;
+	struct game *g = &s->game;
+	if (gameIsOver(g)){
+		host->ranked = updateLeaderboard(host->board, host->leaderboard, g->player, 1); //the rank is shown on the game over screen
+		if (host->saveCache != NULL)
+			saveGame(host->saveCache, host->leaderboard, g->player, &g->shoe, &g->playerHand, &g->dealerHand, g->vars);
+		if (host->profiles != NULL)
+			profileRemove(host->profiles, g->player.name);
+		return;
+	}
+	if (host->saveCache != NULL){
+		if (saveCacheRecord(host->saveCache, SAVE_PATH, g->player, g->vars)){
+			saveGame(host->saveCache, host->leaderboard, g->player, &g->shoe, &g->playerHand, &g->dealerHand, g->vars);
+		}
+	}
+	if (host->profiles != NULL){
+		profileSave(host->profiles, g);
+	}
+}
+
+//runs the game on from its gameState until the player has to answer something
+static void sessionAdvance(struct session *s){
+	struct sessionHost *host = s->host;
+	struct game *g = &s->game;
+	int lower, upper;
+	
+	for (;;){
+		switch (g->vars.gameState){ 	// C1: SELECTION
+			case 0: //start of round
+				gameDealFirst(g); //dealing opening cards
+				displayTable(g, 1);
+				if (host->strategy != NULL){
+					int first = cardRank(g->playerHand.cards[0]);
+					int up = cardRank(g->dealerHand.cards[0]);
+					screenPrintf("HINT: bet $%d (EV %+.3f per $1)\n", host->strategy->betEv[first][up] > 0 ? 10 : 1, host->strategy->betEv[first][up]);
 				}
-				break;	
+				screenPrintf("How much is your initial bet? Must be between $1 and $10\n");
+				s->step = STEP_BET;
+				return;
 				
-			case 3: //leaderboard
-				system("cls");
-				printArt();
-				printHighScore();
-				for (int i = 0; i < 10; i++){
-					if(i<9) //formating with leading 0
-						printf("0%d) %s %d\n", i+1, leaderboard[i].name, leaderboard[i].score);
-					else 
-						printf("%d) %s %d\n", i+1, leaderboard[i].name, leaderboard[i].score);
+			case 1:{ //checking if dealer or player has blackjack
+				enum roundEventEnum event = gameCheckBlackjack(g);
+				if (g->vars.gameState == 6)
+					sessionRoundOver(s);
+				switch (event){
+					case EVENT_BOTH_BLACKJACK: //"pass" round
+						displayTable(g, 1);
+						screenPrintf("You were both dealt blackjack!\nNothing is won or lost.\n");
+						sessionPause(s, STEP_CONTINUE);
+						return;
+					case EVENT_DEALER_BLACKJACK: //only dealer has blackjack, instant loss
+						displayTable(g, 1);
+						screenPrintf("Dealer was dealt blackjack!\nYou lose $%ld.\n", -g->roundResult);
+						sessionPause(s, STEP_CONTINUE);
+						return;
+					default: //player turn, or resolving a player blackjack
+						break;
 				}
-				enterToContinue();
-				break;
-			
-			case 4: //info
-				displayInfo();
 				break;
+			}
 				
-			case 5: //quit
-				exitProgram = 1;
-				break;		
-		}
-		
-		//game playing loop
-		while (!exitGame){ 					// C7: LOOP	
-			switch (gameState){ 			// C1: SELECTION
-				
-				case 0: //start of round
-					system("cls"); 
-					
-					//setting new round variables
-					drawPosition = 0;
-					initialBet = 0;
-					totalBet = 0;
-					firstBuy = -1;
-					handNumber++;
-					resetCards(deck, playerHand, dealerHand);
-					
-					printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-					
-					//dealing opening cards
-					playerHand[0] = deck[drawPosition++];
-					dealerHand[0] = deck[drawPosition++];
-						
-					//displaying hands
-					printf("DEARLER'S HAND:\n");
-					displayHand(dealerHand);
-					printf("YOUR HAND:\n");
-					displayHand(playerHand);
-					
-					//placing initial bet
-					printf("How much is your initial bet? Must be between $1 and $10\n");
-					userInput = -1;
-					while (userInput==-1){
-						userInput = multiDigitInput(1, 10);
-						if (userInput ==-1){
-							printf("Correct input only, please\n");
-						}
-					}			
-					initialBet = userInput;
-					totalBet += initialBet;
-					printf("You're betting $%d!\n", userInput);	
-					
-					//drawing second card
-					playerHand[1] = deck[drawPosition++];
-					dealerHand[1] = deck[drawPosition++];
-					
-					gameState = 1;
-					break;
-					
-				case 1: //checking if dealer or player has blackjack
-					
-					
-					if (handResolve(dealerHand) == BLACKJACK && handResolve(playerHand) == BLACKJACK){
-						//both player hand dealer have blackjack, "pass" round
-						
-						system("cls");
-						printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-						printf("DEARLER'S HAND:\n");
-						displayHand(dealerHand);
-						printf("YOUR HAND:\n");
-						displayHand(playerHand);
-						printf("You were both dealt blackjack!\nNothing is won or lost.\n");
-						
-						enterToContinue();
-						gameState = 6;
-					} else if (handResolve(dealerHand) == BLACKJACK && handResolve(playerHand) != BLACKJACK){
-						//only dealer has blackjack, instant loss
-						
-						system("cls");
-						money -= (2*initialBet);
-						printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-						
-						printf("DEARLER'S HAND:\n");
-						displayHand(dealerHand);
-						printf("YOUR HAND:\n");
-						displayHand(playerHand);
-						printf("Dealer was dealt blackjack!\nYou lose $%d.\n", (2*initialBet) );
-						
-						enterToContinue();
-						gameState = 6;
-					} else if (handResolve(playerHand) == BLACKJACK){ //player has blackjack, goes straight to resolving hand
-						gameState = 3;
-					} else{
-						gameState = 2; //neither have blackjack, going to player turn
-					}
-					break;
+			case 2: //player turn
+				displayTable(g, 0);
 				
-				case 2: //player turn
-					
-					//showing shit
-					system("cls");
-					printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-					printf("DEALER'S HAND:\n");
-					displayFirstCard(dealerHand);
-					printf("YOUR HAND:\n");
-					displayHand(playerHand);
-					
-					//checking if player has bought before this round
-					if (firstBuy == -1){
-						printf("\nYour turn:\n[1] BUY a card (between $%d, and $%d)\n[2] TWIST a card\n[3] STICK with current hand\n[4] SAVE and QUIT to title\n", initialBet, 2*initialBet);
-					} else {
-						printf("\nYour turn:\n[1] BUY a card (between $%d, and $%d)\n[2] TWIST a card\n[3] STICK with current hand\n[4] SAVE and QUIT to title\n", initialBet, firstBuy);
-					}
-					
-					//getting user menu input
-					userInput = -1;
-					while (userInput == -1){
-						userInput = singleDigitInput('1', '4');
-						if (userInput == -1)
-							printf("Correct input only, please\n");
-					}
-					
-					//resolving user menu input
-					switch (userInput){
-						case 1: //buy
-							printf("Please input how much you wish to buy for\n");
-							userInput = -1;
-							while (userInput==-1){
-								
-								//constraining buy values as appropreate (depends on if player has bought before this round)
-								if (firstBuy == -1){
-									userInput = multiDigitInput(initialBet, 2*initialBet);
-								} else {
-									userInput = multiDigitInput(initialBet, firstBuy);
-								}
-								
-								if (userInput ==-1){
-									printf("Correct input only, please\n");
-								}
-							}
-							
-							//setting first buy if appropriate
-							if (firstBuy ==-1){
-								firstBuy = userInput;
-								totalBet += firstBuy;
-							} else{
-								totalBet += userInput;
-							}
-							
-							topDraw(playerHand, deck, &drawPosition); //drawing card
-							gameState = 3; //resolving hand
-							break;
-						case 2: //twist 
-							topDraw(playerHand, deck, &drawPosition); //drawing card
-							gameState = 3; //resolving hand			
-							break;
-						
-						case 3: //stick
-							printf("You've stuck with a hand value of %d.\nIt's now the dealer's turn.\n", handValue(playerHand));
-							enterToContinue();
-							gameState = 4;
+				//limits depend on if player has bought before this round
+				gameBuyLimits(g, &lower, &upper);
+				screenPrintf("\nYour turn:\n[1] BUY a card (between $%d, and $%d)\n[2] TWIST a card\n[3] STICK with current hand\n[4] SAVE and QUIT to title\n", lower, upper);
+				if (host->strategy != NULL){
+					int ev;
+					switch (strategyLookup(host->strategy, g, &ev)){
+						case STRAT_STICK:
+							screenPrintf("HINT: STICK (EV %+.3f x initial bet)\n", ev / 1000.0);
 							break;
-						
-						case 4: //save and quit
-							
-							updateLeaderboard(leaderboard, currentPlayer); //updating leaderboard(current player goes in if elegible)
-							
-							//setting gameVariable struct variables to save
-							gameVariables.drawPosition = drawPosition; 			//C5: USE OF DRAWPOSITION VARIABLE
-							gameVariables.firstBuy = firstBuy;
-							gameVariables.gameState = gameState;
-							gameVariables.handNumber = handNumber;
-							gameVariables.initialBet = initialBet;
-							gameVariables.money = money;
-							gameVariables.totalBet = totalBet;							
-							saveGame(&fIO, leaderboard, currentPlayer, deck, playerHand, dealerHand, gameVariables); 
-							exitGame = 1;
+						case STRAT_TWIST:
+							screenPrintf("HINT: TWIST (EV %+.3f x initial bet)\n", ev / 1000.0);
 							break;
-					}
-					break;
-				case 3:{ //resolving player turn	
-					enum handRankingEnum playerHandRanking;
-					playerHandRanking = handResolve(playerHand); //function that returns playerh's hand rank
-					switch (playerHandRanking)	{ //behaviour varies based on rank
-						case BLACKJACK:
-							//player cannot take more cards, dealer's turn
-							system("cls");
-							printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-							printf("DEALER'S HAND:\n");
-							displayFirstCard(dealerHand);
-							printf("YOUR HAND:\n");
-							displayHand(playerHand);
-							printf("You've got blackjack! It's now the dealer's turn.\n");
-							enterToContinue();
-							gameState = 4;
-							break;
-						case FIVE_CARD_TRICK:
-							//player cannot take more card, dealer's turn
-							system("cls");
-							printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-							printf("DEALER'S HAND:\n");
-							displayFirstCard(dealerHand);
-							printf("YOUR HAND:\n");
-							displayHand(playerHand);
-							printf("You've got a five card trick! It's now the dealer's turn.\n");
-							enterToContinue();
-							gameState = 4;
-							break;
-						case TWENTYONE:
-							//player cannot take more cards, dealer's turn
-							system("cls");
-							printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-							printf("DEALER'S HAND:\n");
-							displayFirstCard(dealerHand);
-							printf("YOUR HAND:\n");
-							displayHand(playerHand);
-							printf("You've got 21! It's now the dealer's turn.\n");
-							enterToContinue();
-							gameState = 4;
+						case STRAT_BUY_LOW:
+							screenPrintf("HINT: BUY for $%d (EV %+.3f x initial bet)\n", lower, ev / 1000.0);
 							break;
-							
-						case NOT_BUST:
-							//player can take more cards, takes another turn
-							gameState = 2;
+						case STRAT_BUY_HIGH:
+							screenPrintf("HINT: BUY for $%d (EV %+.3f x initial bet)\n", upper, ev / 1000.0);
 							break;
-
-						case BUST:
-							//player goes bust and loses the round
-							money -= totalBet;
-							system("cls");
-							printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-							printf("DEALER'S HAND:\n");
-							displayFirstCard(dealerHand);
-							printf("YOUR HAND:\n");
-							displayHand(playerHand);
-							printf("You've gone bust! You lose $%d!\n", totalBet);
-							enterToContinue();
-							gameState = 6;
+						default:
 							break;
 					}
-					break;
 				}
-					
-				case 4: //dealer's turn
-					system("cls");	
-					printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-					printf("DEALER'S HAND:\n");
-					displayHand(dealerHand);
-					printf("YOUR HAND:\n");
-					displayHand(playerHand);
-					
-					//if  dealer has more than 17 and isn't bust, he must stick
-					if (handValue(dealerHand) >= 17 && handResolve(dealerHand) != BUST){
-						printf("The dealer sticks with %d.\n", handValue(dealerHand));
-						enterToContinue();
-						gameState = 5;
-					}
-					
-					//less than 17, dealer must hit
-					while (handValue(dealerHand) < 17){
-						printf("The dealer draws a new card.\n");
-						enterToContinue();
-						
-						topDraw(dealerHand, deck, &drawPosition);
-	
-						if(handResolve(dealerHand) != NOT_BUST){ //if dealer has anything that isn't "not bust"
-																 //i.e blackjack, FCT, 21, or BUST, game goes to resolve hands
-							gameState = 5;
-							break;
-						} else{ //dealer isn't bust yet, taes another turn
-							system("cls");	
-							printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-							printf("DEALER'S HAND:\n");
-							displayHand(dealerHand);
-							printf("YOUR HAND:\n");
-							displayHand(playerHand);
-						}
-					}
-					break;
-				case 5:{ //resolving both hands
+				s->step = STEP_ACTION;
+				return;
 				
-					enum handRankingEnum dealerRanking = handResolve(dealerHand); //resolving dealer hand
-				
-					switch (dealerRanking){
-						case BUST: //dealer bust, player wins
-
-							money += totalBet;
-							currentPlayer.score +=totalBet;
-							system("cls");	
-							printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-							printf("DEALER'S HAND:\n");
-							displayHand(dealerHand);
-							printf("YOUR HAND:\n");							
-							displayHand(playerHand);						
-							printf("The dealer went bust!\nYou win $%d\n", totalBet);	
-							enterToContinue();	
-							gameState = 6;
-							break;
-						
-						case FIVE_CARD_TRICK:{ //dealer FCT, player only wins on blackjack
-
-							char outString[80]; //formatting output string depending on win/loss
-							if (handResolve(playerHand) == BLACKJACK){
-								sprintf(outString, "Your BLACKJACK beats the dealer's FIVE CARD TRICK.\nYou win $%d!\n", 2*totalBet);
-								money += 2*totalBet;
-								currentPlayer.score += 2*totalBet;
-							} else if (handResolve(playerHand) == FIVE_CARD_TRICK){
-								sprintf(outString, "The dealer's FIVE CARD TRICK beats your FIVE CARD TRICK!\nYou lose $%d.", 2*totalBet);
-								money -= 2*totalBet;
-							} else if (handResolve(playerHand) == TWENTYONE || handResolve(playerHand) == NOT_BUST){
-								sprintf(outString, "The dealer's FIVE CARD TRICK beats your %d!\nYou lose $%d.", handValue(playerHand), 2*totalBet);
-								money -= 2*totalBet;
-							}
-							
-							//printing screen and outstring
-							system("cls");	
-							printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-							printf("DEALER'S HAND:\n");
-							displayHand(dealerHand);
-							printf("YOUR HAND:\n");							
-							displayHand(playerHand);
-							printf(outString);							
-							enterToContinue();	
-							gameState = 6;
-							break;	
-						}
-						default:{ //dealer gets 21 or less, player only wins of blackjack or FCT
-							
-							char outString[80]; //output string to deplay, depending on player win/loss
-							if (handResolve(playerHand) == BLACKJACK){ //player gets blackjack
-								sprintf(outString, "Your BLACKJACK beats the dealer's %d!\nYou win $%d!\n", handValue(dealerHand), 2*totalBet);
-								money += 2*totalBet;
-								currentPlayer.score += 2*totalBet;
-							} else if (handResolve(playerHand) == FIVE_CARD_TRICK){
-								sprintf(outString, "Your FIVE CARD TRICK beats the dealer's %d!\nYou win $%d!\n", handValue(dealerHand), 2*totalBet);
-								money += 2*totalBet;
-								currentPlayer.score += 2*totalBet;
-							} else if (handValue(playerHand) > handValue(dealerHand)){
-								sprintf(outString, "Your %d beats the dealer's %d!\nYou win $%d!\n", handValue(playerHand), handValue(dealerHand), totalBet);
-								money += totalBet;
-								currentPlayer.score += totalBet;
-							} else{
-								sprintf(outString, "The dealer's %d beats your %d!\nYou lose $%d.\n", handValue(dealerHand), handValue(playerHand), totalBet);
-								money-= totalBet;								
-							}
-							
-							//displaying outstring
-							system("cls");	
-							printHeader(currentPlayer.name, handNumber, money, initialBet, totalBet, currentPlayer.score);
-							printf("DEALER'S HAND:\n");
-							displayHand(dealerHand);
-							printf("YOUR HAND:\n");		
-							displayHand(playerHand);
-							printf(outString);
-							gameState = 6;			
-							enterToContinue();		
-							break;	
-						}
-					}
-					break;
-					
-					case 6: //GAMEOVER or prompting user to play again
-						if (money <=0){ //money <0, gameover
-						system("cls");
-						printArt();
-						printf("\n\n");
-						printGameOver();
-						printf("\n\nYou have $%d. Your score was: %d\n", money, currentPlayer.score);
-						enterToContinue();
-						
-						//saving game to update/save leaderboard
-						updateLeaderboard(leaderboard, currentPlayer);
-						gameVariables.drawPosition = drawPosition;
-						gameVariables.firstBuy = firstBuy;
-						gameVariables.gameState = gameState;
-						gameVariables.handNumber = handNumber;
-						gameVariables.initialBet = initialBet;
-						gameVariables.money = money;
-						gameVariables.totalBet = totalBet;							
-						saveGame(&fIO, leaderboard, currentPlayer, deck, playerHand, dealerHand , gameVariables);
-						
-						exitGame = 1;
-						} else { //promting user to player another round
-						
-						
-						system("cls");
-						printHeader(currentPlayer.name, handNumber, money, 0, 0, currentPlayer.score);
-						printf("Would you like to play another hand?\n[1] YES\n[2] SAVE and QUIT to title\n");
-						
-						int playerInput = -1;
-						
-						while (playerInput == -1){
-							playerInput = singleDigitInput('1', '2');
-							if (playerInput == -1)
-								printf("Correct input only, please\n");
-						}
-						
-						if (playerInput == 1){ //player plays another round
-							gameState = 0;
-						} else{ //player saves and quits
-							updateLeaderboard(leaderboard, currentPlayer);
-							gameVariables.drawPosition = drawPosition;
-							gameVariables.firstBuy = firstBuy;
-							gameVariables.gameState = gameState;
-							gameVariables.handNumber = handNumber;
-							gameVariables.initialBet = initialBet;
-							gameVariables.money = money;
-							gameVariables.totalBet = totalBet;							
-							saveGame(&fIO, leaderboard, currentPlayer, deck, playerHand, dealerHand , gameVariables);
-							
-							exitGame = 1;
-							break;
-						}
-						}
+			case 3:{ //resolving player turn
+				enum roundEventEnum event = gameResolvePlayer(g);
+				if (g->vars.gameState == 6)
+					sessionRoundOver(s);
+				switch (event){
+					case EVENT_PLAYER_BLACKJACK:
+						displayTable(g, 0);
+						screenPrintf("You've got blackjack! It's now the dealer's turn.\n");
+						sessionPause(s, STEP_CONTINUE);
+						return;
+					case EVENT_PLAYER_FIVE_CARD_TRICK:
+						displayTable(g, 0);
+						screenPrintf("You've got a five card trick! It's now the dealer's turn.\n");
+						sessionPause(s, STEP_CONTINUE);
+						return;
+					case EVENT_PLAYER_TWENTYONE:
+						displayTable(g, 0);
+						screenPrintf("You've got 21! It's now the dealer's turn.\n");
+						sessionPause(s, STEP_CONTINUE);
+						return;
+					case EVENT_PLAYER_BUST:
+						displayTable(g, 0);
+						screenPrintf("You've gone bust! You lose $%d!\n", g->vars.totalBet);
+						sessionPause(s, STEP_CONTINUE);
+						return;
+					default: //not bust, player takes another turn
 						break;
 				}
-			} //close gamestate switch
-		} //end game while
-		} //end file check
-		else{
-			printf("\nERROR: \"save.txt\" not found. Aborting program.\n");
-			return(1); //main returns 1 (error)
+				break;
+			}
+				
+			case 4: //dealer's turn, one draw per pause
+				displayTable(g, 1);
+				if (gameDealerMustDraw(g)){
+					screenPrintf("The dealer draws a new card.\n");
+				} else{
+					screenPrintf("The dealer sticks with %d.\n", handValue(&g->dealerHand));
+				}
+				gameDealerTurn(g);
+				sessionPause(s, STEP_CONTINUE);
+				return;
+				
+			case 5:{ //resolving both hands
+				enum roundEventEnum result = gameSettle(g);
+				sessionRoundOver(s);
+				displayTable(g, 1);
+				displaySettlement(g, result);
+				sessionPause(s, STEP_CONTINUE);
+				return;
+			}
+				
+			case 6: //GAMEOVER or prompting user to play again
+				if (gameIsOver(g)){ //money <0, gameover
+					screenClear();
+					printArt();
+					screenPrintf("\n\n");
+					printGameOver();
+					screenPrintf("\n\nYou have $%ld. Your score was: %ld\n", g->vars.money, g->player.score);
+					screenPrintf("Your best puts you #%ld of %ld\n", rankSharedRankOf(host->board, g->player.name), host->ranked); //submitted by sessionRoundOver
+					sessionPause(s, STEP_BACK);
+					return;
+				}
+				
+				screenClear();
+				printHeader(g->player.name, g->vars.handNumber, g->vars.money, 0, 0, g->player.score);
+				screenPrintf("Would you like to play another hand?\n[1] YES\n[2] SAVE and QUIT to title\n");
+				s->step = STEP_AGAIN;
+				return;
+				
+			default: //a damaged save, nothing to carry on
+				screenPrintf("ERROR: this game can't be carried on\n");
+				sessionPause(s, STEP_BACK);
+				return;
 		}
-	} //end title while
+	}
+}
 
-	printf("Thanks for playing!");
-	return(0);	//main returns 0 (execution okay)
-} 
+//LOAD GAME with nothing picked: the last game in save.bin, or a new one if that game was over
+static void sessionLoadLast(struct session *s){
+	struct sessionHost *host = s->host;
+	struct game *g = &s->game;
+	if (host->saveCache == NULL){ //only the interactive game has a last game
+		sessionTitle(s);
+		return;
+	}
+	loadGame(&host->saveCache->save, host->leaderboard, &g->player, &g->shoe, &g->playerHand, &g->dealerHand, &g->vars);
+	if (g->vars.money <= 0){ //if old save money < 0, starts new game instead
+		screenPrintf("Starting New Game\nPlease enter your name! (max 16 chars, excess will be truncated)\n");
+		s->step = STEP_NAME;
+		return;
+	}
+	sessionAdvance(s);
+}
 
-enum handRankingEnum handResolve(struct card *hand){ //scoring hand
-	
+void sessionStart(struct session *s, struct sessionHost *host){
+	memset(s, 0, sizeof(*s));
+	s->host = host;
+	s->game.decks = host->decks;
+	s->game.penetration = host->penetration;
+	rngSeed(&s->game.rng, host->seed, host->started++); //every session its own stream
+	sessionTitle(s);
+	if (host->promptLines)
+		sessionPromptLine(s);
+}
+
+void sessionInput(struct session *s, const char *line){
+	struct sessionHost *host = s->host;
+	struct game *g = &s->game;
+	int lower, upper, n;
+	
+	switch (s->step){
+		case STEP_TITLE: //title menu
+			switch (sessionNumber(line, 1, 5)){ 				// C1: SELECTION
+				case 1: //new game
+					screenPrintf("Starting New Game\nPlease enter your name! (max 16 chars, excess will be truncated)\n");
+					s->step = STEP_NAME;
+					break;
+				case 2:{ //load game, from a profile or the last game
+					char names[10][PROFILE_NAME];
+					int listed;
+					long count = host->profiles != NULL ? profileList(host->profiles, names, 10, &listed) : 0;
+					if (count == 0){
+						sessionLoadLast(s);
+						break;
+					}
+					screenPrintf("Saved profiles (%ld):", count);
+					for (int i = 0; i < listed; i++){
+						SCREEN_LITERAL(" ");
+						screenString(names[i]);
+					}
+					screenString(count > listed ? " ...\n" : "\n");
+					if (host->saveCache != NULL){
+						screenPrintf("Enter a name to load, or leave blank to carry on the last game\n");
+					} else{
+						screenPrintf("Enter a name to load, or leave blank to go back\n");
+					}
+					s->step = STEP_PROFILE;
+					break;
+				}
+				case 3: //leaderboard
+					screenClear();
+					printArt();
+					printHighScore();
+					for (int i = 0; i < 10; i++){
+						if (i < 9) //formating with leading 0
+							SCREEN_LITERAL("0");
+						screenLong(i+1);
+						SCREEN_LITERAL(") ");
+						screenString(host->leaderboard[i].name);
+						SCREEN_LITERAL(" ");
+						screenLong(host->leaderboard[i].score);
+						SCREEN_LITERAL("\n");
+					}
+					screenPrintf("%ld players ranked\n", host->ranked);
+					sessionPause(s, STEP_BACK);
+					break;
+				case 4: //info
+					displayInfo(1);
+					sessionPause(s, STEP_INFO);
+					break;
+				case 5: //quit
+					s->step = STEP_DONE;
+					break;
+				default:
+					screenPrintf("Correct input only, please\n");
+					break;
+			}
+			break;
+			
+		case STEP_NAME:{
+			char name[PROFILE_NAME];
+			memset(name, 0, sizeof(name));
+			memcpy(name, line, strnlen(line, PROFILE_NAME - 1)); //excess is truncated
+			if (strlen(name) == 0){ //zero length
+				screenPrintf("Invalid input\n");
+			} else if (strchr(name, ' ') != NULL){ //includes space
+				screenPrintf("Invalid input (no spaces)\n");
+			} else{
+				memcpy(g->player.name, name, sizeof(name));
+				gameNew(g); //populating the shoe, empty hands, starting money
+				sessionAdvance(s);
+			}
+			break;
+		}
+		
+		case STEP_PROFILE:{
+			char name[PROFILE_NAME];
+			memset(name, 0, sizeof(name));
+			memcpy(name, line, strnlen(line, PROFILE_NAME - 1)); //names are truncated the same way a new game does
+			if (strlen(name) == 0){
+				sessionLoadLast(s);
+				break;
+			}
+			int loaded = profileLoad(host->profiles, name, g);
+			if (loaded == 1){
+				sessionAdvance(s); //a finished game's profile is gone, so there's money left
+			} else{
+				if (loaded == -1){
+					SCREEN_LITERAL("\"");
+					screenString(name);
+					SCREEN_LITERAL("\" is damaged, try another name\n");
+				} else{
+					SCREEN_LITERAL("No saved game for \"");
+					screenString(name);
+					SCREEN_LITERAL("\", try again\n");
+				}
+			}
+			break;
+		}
+		
+		case STEP_BET: //placing initial bet
+			if ((n = sessionNumber(line, 1, 10)) == -1){
+				screenPrintf("Correct input only, please\n");
+				break;
+			}
+			screenPrintf("You're betting $%d!\n", n);
+			gamePlaceBet(g, n); //drawing second card
+			sessionAdvance(s);
+			break;
+			
+		case STEP_ACTION: //resolving user menu input
+			switch (sessionNumber(line, BUY, SAVE_QUIT)){
+				case BUY:
+					screenPrintf("Please input how much you wish to buy for\n");
+					s->step = STEP_BUY;
+					break;
+				case TWIST:
+					gameTwist(g);
+					sessionAdvance(s);
+					break;
+				case STICK:
+					screenPrintf("You've stuck with a hand value of %d.\nIt's now the dealer's turn.\n", handValue(&g->playerHand));
+					gameStick(g);
+					sessionPause(s, STEP_CONTINUE);
+					break;
+				case SAVE_QUIT:
+					sessionSaveQuit(s);
+					break;
+				default:
+					screenPrintf("Correct input only, please\n");
+					break;
+			}
+			break;
+			
+		case STEP_BUY:
+			gameBuyLimits(g, &lower, &upper);
+			if ((n = sessionNumber(line, lower, upper)) == -1){
+				screenPrintf("Correct input only, please\n");
+				break;
+			}
+			gameBuy(g, n);
+			sessionAdvance(s);
+			break;
+			
+		case STEP_CONTINUE:
+			sessionAdvance(s);
+			break;
+			
+		case STEP_AGAIN:
+			switch (sessionNumber(line, 1, 2)){
+				case 1: //player plays another round
+					g->vars.gameState = 0;
+					sessionAdvance(s);
+					break;
+				case 2: //player saves and quits
+					sessionSaveQuit(s);
+					break;
+				default:
+					screenPrintf("Correct input only, please\n");
+					break;
+			}
+			break;
+			
+		case STEP_INFO:
+			displayInfo(2);
+			sessionPause(s, STEP_BACK);
+			break;
+			
+		case STEP_BACK:
+			sessionTitle(s);
+			break;
+			
+		default: //done, nothing more to answer
+			return;
+	}
+	if (host->promptLines)
+		sessionPromptLine(s);
+}
+
+//a game underway (not between being dealt and betting, that would be a free redeal) that a dropped session should keep
+int sessionPlaying(enum sessionStepEnum step){
+	return step == STEP_ACTION || step == STEP_BUY || step == STEP_CONTINUE || step == STEP_AGAIN;
+}
+
+void sessionPack(const struct session *s, struct sessionPacked *packed){
+	const struct game *g = &s->game;
+	memset(packed, 0, sizeof(*packed));
+	packed->rng = g->rng;
+	memcpy(packed->name, g->player.name, sizeof(packed->name));
+	packed->score = g->player.score;
+	packed->money = g->vars.money;
+	packed->handNumber = g->vars.handNumber;
+	packed->roundResult = g->roundResult;
+	packed->drawPosition = g->vars.drawPosition;
+	packed->cut = g->shoe.cut;
+	packed->step = s->step;
+	packed->gameState = g->vars.gameState;
+	packed->decks = g->shoe.decks;
+	packed->initialBet = g->vars.initialBet;
+	packed->totalBet = g->vars.totalBet;
+	packed->firstBuy = g->vars.firstBuy;
+	for (int i = 0; i < TRICK_MAX; i++){
+		packed->playerCards[i] = g->playerHand.cards[i].code;
+		packed->dealerCards[i] = g->dealerHand.cards[i].code;
+	}
+	for (int i = 0; i < g->vars.drawPosition; i++){
+		int code = g->shoe.cards[i].code - 1;
+		packed->dealt[code / 2] += code % 2 ? 16 : 1;
+	}
+}
+
+//the shoe comes back as the dealt cards in card order, then the undealt ones: which undealt card is where
+//doesn't matter since shoeDraw picks among them at random
+void sessionUnpack(const struct sessionPacked *packed, struct sessionHost *host, struct session *s){
+	struct game *g = &s->game;
+	s->step = packed->step;
+	s->host = host;
+	g->rng = packed->rng;
+	memcpy(g->player.name, packed->name, sizeof(g->player.name));
+	g->player.score = packed->score;
+	g->vars.money = packed->money;
+	g->vars.handNumber = packed->handNumber;
+	g->vars.drawPosition = packed->drawPosition;
+	g->vars.initialBet = packed->initialBet;
+	g->vars.totalBet = packed->totalBet;
+	g->vars.firstBuy = packed->firstBuy;
+	g->vars.gameState = packed->gameState;
+	g->roundResult = packed->roundResult;
+	g->decks = host->decks;
+	g->penetration = host->penetration;
+	
+	g->shoe.decks = packed->decks;
+	g->shoe.cut = packed->cut;
+	int dealt = 0, undealt = packed->drawPosition;
+	for (int code = 1; code <= 52; code++){
+		int count = (packed->dealt[(code - 1) / 2] >> ((code - 1) % 2 * 4)) & 15;
+		for (int d = 0; d < packed->decks; d++){
+			g->shoe.cards[d < count ? dealt++ : undealt++].code = code;
+		}
+	}
+	
+	for (int i = 0; i < TRICK_MAX; i++){
+		g->playerHand.cards[i].code = packed->playerCards[i];
+		g->dealerHand.cards[i].code = packed->dealerCards[i];
+	}
+	handRecount(&g->playerHand);
+	handRecount(&g->dealerHand);
+}
+
+enum handRankingEnum handResolve(const struct hand *hand){ //scoring hand under the house rules
+	return rulesResolve(hand, HOUSE_RULES);
+}
+
+RULES_INLINE enum handRankingEnum rulesResolve(const struct hand *hand, RULES_PARAMS){
+	(void)hitSoft17; (void)blackjackPays; (void)trickPays; //every rule comes in, only the trick size matters here
+	int value = handValue(hand);
+	
+	//bust
+	if (value > 21)
+		return BUST;
+	
 	//blackjack
-	if (handSize(hand) == 2 && handValue(hand)==21)
+	else if (hand->size == 2 && value == 21)
 		return BLACKJACK;
 		
-	//fivecardtrick
-	else if (handSize(hand) == 5 && handValue(hand) <= 21)
+	//fivecardtrick (or however many cards the rules want)
+	else if (hand->size == trickCards)
 		return FIVE_CARD_TRICK;
 	
 	//twentyone
-	else if (handValue(hand) == 21)
+	else if (value == 21)
 		return TWENTYONE;
 	
 	//not bust
-	else if (handValue(hand) <= 21)
+	else
 		return NOT_BUST;
+}
+
+//empties hands, no reshuffle needed: deckDraw picks each card at random from whatever hasn't been drawn yet,
+//so the order the last round left the deck in doesn't matter
+void resetCards(struct hand *playerHand, struct hand *dealerHand){
+	handEmpty(playerHand);
+	handEmpty(dealerHand);
+}
+
 	
-	//bust
-	else if (handValue(hand) > 21)
-		return BUST;
+//clears screen and shows the header with both hands, dealer's hole card hidden unless showDealer
+void displayTable(const struct game *g, int showDealer){
+	screenClear();
+	printHeader(g->player.name, g->vars.handNumber, g->vars.money, g->vars.initialBet, g->vars.totalBet, g->player.score);
+	displayHands(g, showDealer);
+}
+
+void displayHands(const struct game *g, int showDealer){
+	SCREEN_LITERAL("SHOE: ");
+	screenLong(g->shoe.decks);
+	SCREEN_LITERAL(" DECK(S), ");
+	screenLong(52 * g->shoe.decks - g->vars.drawPosition);
+	SCREEN_LITERAL(" CARDS LEFT, ");
+	screenLong(g->shoe.cut > g->vars.drawPosition ? g->shoe.cut - g->vars.drawPosition : 0);
+	SCREEN_LITERAL(" TO THE CUT CARD\n\nDEALER'S HAND:\n");
+	if (showDealer){
+		displayHand(&g->dealerHand);
+	} else{
+		displayFirstCard(&g->dealerHand);
+	}
+	SCREEN_LITERAL("YOUR HAND:\n");
+	displayHand(&g->playerHand);
+}
+
+//the frame being built and what the terminal is showing, one per program since there's one terminal
+static struct screen screen = {.terminal = -1, .fresh = 1};
+
+//starts a new frame, replaces system("cls"): nothing is sent until the next screenFlush
+void screenClear(){
+	screen.length = 0;
+	screen.sent = 0;
+}
+
+//adds to the frame
+void screenPrintf(const char *format, ...){
+	va_list args;
+	va_start(args, format);
+	int room = SCREEN_BYTES - screen.length;
+	int n = vsnprintf(screen.text + screen.length, room, format, args);
+	va_end(args);
+	if (n > 0)
+		screen.length += n < room ? n : room - 1; //a frame that doesn't fit is cut short
+}
+
+//bounded, a frame that doesn't fit is cut short
+void screenWrite(const char *text, int length){
+	int room = SCREEN_BYTES - 1 - screen.length;
+	if (length > room)
+		length = room;
+	memcpy(screen.text + screen.length, text, length);
+	screen.length += length;
+}
+
+void screenString(const char *text){
+	screenWrite(text, strlen(text));
+}
+
+void screenLong(long n){
+	char digits[24];
+	int i = sizeof(digits);
+	unsigned long u = n < 0 ? -(unsigned long)n : (unsigned long)n;
+	do{
+		digits[--i] = '0' + u % 10;
+		u /= 10;
+	} while (u != 0);
+	if (n < 0)
+		digits[--i] = '-';
+	screenWrite(digits + i, sizeof(digits) - i);
+}
+
+//splits text into lines, returns how many (a last line without a newline counts)
+static int screenLines(const char *text, int length, int *starts, int *lengths){
+	int lines = 0, start = 0;
+	for (int i = 0; i < length && lines < SCREEN_LINES; i++){
+		if (text[i] == '\n'){
+			starts[lines] = start;
+			lengths[lines++] = i - start;
+			start = i + 1;
+		}
+	}
+	if (start < length && lines < SCREEN_LINES){
+		starts[lines] = start;
+		lengths[lines++] = length - start;
+	}
+	return lines;
+}
+
+static void screenAppend(const char *bytes, int n){
+	if (screen.outLength + n <= (int)sizeof(screen.out)){
+		memcpy(screen.out + screen.outLength, bytes, n);
+		screen.outLength += n;
+	}
+}
+
+//puts the frame on the terminal in one write: only the lines that differ from what it's showing, each
+//followed by clear to end of line, then everything below the frame is cleared (typed input, old lines)
+//anything that isn't a terminal just gets the new text, so piped output reads as a plain transcript
+void screenFlush(){
+	fflush(stdout); //anything printf'd outside the renderer goes first
+	if (screen.terminal == -1)
+		screen.terminal = isatty(STDOUT_FILENO);
+	if (!screen.terminal){
+		if (screen.length > screen.sent && write(STDOUT_FILENO, screen.text + screen.sent, screen.length - screen.sent) > 0)
+			screen.sent = screen.length;
+		return;
+	}
+	
+	int rows = 0;
+	struct winsize size;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0)
+		rows = size.ws_row;
+	int lines = screenLines(screen.text, screen.length, screen.starts, screen.lengths);
+	int shownLines = screenLines(screen.shown, screen.shownLength, screen.shownStarts, screen.shownLengths);
+	int partial = screen.length > 0 && screen.text[screen.length - 1] != '\n'; //cursor is left on the last line
+	int shownPartial = screen.shownLength > 0 && screen.shown[screen.shownLength - 1] != '\n'; //so whatever was typed there is too
+	
+	char move[32];
+	screen.outLength = 0;
+	if (screen.fresh || rows == 0 || lines + 1 >= rows){ //taller than the terminal, it scrolls, so row numbers mean nothing
+		screenAppend("\x1b[H\x1b[2J", 7);
+		screenAppend(screen.text, screen.length);
+	} else{
+		for (int i = 0; i < lines; i++){
+			if (i < shownLines && !(shownPartial && i == shownLines - 1) && screen.lengths[i] == screen.shownLengths[i]
+				&& memcmp(screen.text + screen.starts[i], screen.shown + screen.shownStarts[i], screen.lengths[i]) == 0)
+				continue;
+			screenAppend(move, snprintf(move, sizeof(move), "\x1b[%d;1H", i + 1));
+			screenAppend(screen.text + screen.starts[i], screen.lengths[i]);
+			screenAppend("\x1b[K", 3);
+		}
+		if (partial){
+			screenAppend(move, snprintf(move, sizeof(move), "\x1b[%d;%dH", lines, screen.lengths[lines - 1] + 1));
+		} else{
+			screenAppend(move, snprintf(move, sizeof(move), "\x1b[%d;1H", lines + 1));
+		}
+		screenAppend("\x1b[J", 3);
+	}
+	
+	for (int done = 0; done < screen.outLength; ){
+		int n = write(STDOUT_FILENO, screen.out + done, screen.outLength - done);
+		if (n <= 0)
+			break;
+		done += n;
+	}
+	memcpy(screen.shown, screen.text, screen.length);
+	screen.shownLength = screen.length;
+	screen.sent = screen.length;
+	screen.fresh = 0;
+}
+
+void displayFirstCard(const struct hand *hand) { //displays only first card for dealer
+	SCREEN_LITERAL("1) ");
+	screenCard(hand->cards[0]);
+	SCREEN_LITERAL("\n2) ?\n\n");
+}
+
+void displayHand(const struct hand *hand){ //displays whole hand
+	for (int i = 0; i < hand->size; i++){
+		screenLong(i+1);
+		SCREEN_LITERAL(") ");
+		screenCard(hand->cards[i]);
+		SCREEN_LITERAL("\n");
+	}
+	SCREEN_LITERAL("Value: ");
+	screenLong(handValue(hand));
+	SCREEN_LITERAL("\n\n");
+}
+
+//state 5's result, fixed text and numbers written straight into the frame
+void displaySettlement(const struct game *g, enum roundEventEnum result){
+	long amount = labs(g->roundResult);
+	int dealerValue = handValue(&g->dealerHand);
+	int playerValue = handValue(&g->playerHand);
+	
+	switch (result){
+		case EVENT_DEALER_BUST:
+			SCREEN_LITERAL("The dealer went bust!\nYou win $");
+			screenLong(amount);
+			SCREEN_LITERAL("\n");
+			break;
+		case EVENT_BLACKJACK_BEATS_TRICK:
+			SCREEN_LITERAL("Your BLACKJACK beats the dealer's FIVE CARD TRICK.\nYou win $");
+			screenLong(amount);
+			SCREEN_LITERAL("!\n");
+			break;
+		case EVENT_TRICK_BEATS_TRICK:
+			SCREEN_LITERAL("The dealer's FIVE CARD TRICK beats your FIVE CARD TRICK!\nYou lose $");
+			screenLong(amount);
+			SCREEN_LITERAL(".\n");
+			break;
+		case EVENT_TRICK_BEATS_HAND:
+			SCREEN_LITERAL("The dealer's FIVE CARD TRICK beats your ");
+			screenLong(playerValue);
+			SCREEN_LITERAL("!\nYou lose $");
+			screenLong(amount);
+			SCREEN_LITERAL(".\n");
+			break;
+		case EVENT_BLACKJACK_WINS:
+			SCREEN_LITERAL("Your BLACKJACK beats the dealer's ");
+			screenLong(dealerValue);
+			SCREEN_LITERAL("!\nYou win $");
+			screenLong(amount);
+			SCREEN_LITERAL("!\n");
+			break;
+		case EVENT_TRICK_WINS:
+			SCREEN_LITERAL("Your FIVE CARD TRICK beats the dealer's ");
+			screenLong(dealerValue);
+			SCREEN_LITERAL("!\nYou win $");
+			screenLong(amount);
+			SCREEN_LITERAL("!\n");
+			break;
+		case EVENT_HAND_WINS:
+			SCREEN_LITERAL("Your ");
+			screenLong(playerValue);
+			SCREEN_LITERAL(" beats the dealer's ");
+			screenLong(dealerValue);
+			SCREEN_LITERAL("!\nYou win $");
+			screenLong(amount);
+			SCREEN_LITERAL("!\n");
+			break;
+		default:
+			SCREEN_LITERAL("The dealer's ");
+			screenLong(dealerValue);
+			SCREEN_LITERAL(" beats your ");
+			screenLong(playerValue);
+			SCREEN_LITERAL("!\nYou lose $");
+			screenLong(amount);
+			SCREEN_LITERAL(".\n");
+			break;
+	}
+}
+
+int handSize(const struct hand *hand){	 //returns hand size
+	return hand->size;
+}
+
+//value of a hand: at most one ace can count as eleven without going bust, so it's the hard total
+//plus ten if there's an ace and room for it
+int handValue(const struct hand *hand){
+	if (hand->aces > 0 && hand->hardTotal <= 11)
+		return hand->hardTotal + 10;
+	return hand->hardTotal;
+}
+
+//all slots set to null card
+void handEmpty(struct hand *hand){
+	memset(hand, 0, sizeof(*hand));
+}
+
+//adds 1 if ace, 10 if 10 or picture, otherwise adding value
+void handAdd(struct hand *hand, struct card card){
+	hand->cards[hand->size++] = card;
+	hand->hardTotal += cardPoints(card);
+	hand->aces += cardKindOf(card) == ACE;
+}
+
+//counts the non-null cards, used after a hand's cards were filled in directly (loading)
+void handRecount(struct hand *hand){
+	struct hand counted;
+	handEmpty(&counted);
+	for (int i = 0; i < TRICK_MAX; i++){
+		if (hand->cards[i].code != 0)
+			handAdd(&counted, hand->cards[i]);
+	}
+	*hand = counted;
+}
+
+//the simd versions work on card codes directly: code 1-52 becomes kind 1-13 by taking 13 off up to three times,
+//points are min(kind, 10), then value and ranking follow the same rules as handValue/handResolve
+#if defined(__AVX2__)
+static void handBatchResolveSimd(struct handBatch *batch){ //32 hands per instruction
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi8(1);
+	const __m256i ten = _mm256_set1_epi8(10);
+	const __m256i twelve = _mm256_set1_epi8(12);
+	const __m256i thirteen = _mm256_set1_epi8(13);
+	
+	for (int i = 0; i < HAND_BATCH; i += 32){
+		__m256i hard = zero, anyAce = zero, size = zero;
+		for (int slot = 0; slot < 5; slot++){
+			__m256i kind = _mm256_loadu_si256((const __m256i *)&batch->cards[slot][i]);
+			for (int k = 0; k < 3; k++){
+				kind = _mm256_sub_epi8(kind, _mm256_and_si256(_mm256_cmpgt_epi8(kind, thirteen), thirteen));
+			}
+			hard = _mm256_add_epi8(hard, _mm256_min_epu8(kind, ten));
+			anyAce = _mm256_or_si256(anyAce, _mm256_cmpeq_epi8(kind, one));
+			size = _mm256_add_epi8(size, _mm256_andnot_si256(_mm256_cmpeq_epi8(kind, zero), one));
+		}
+		
+		__m256i soft = _mm256_and_si256(anyAce, _mm256_cmpgt_epi8(twelve, hard)); //an ace fits as eleven
+		__m256i value = _mm256_add_epi8(hard, _mm256_and_si256(soft, ten));
+		__m256i is21 = _mm256_cmpeq_epi8(value, _mm256_set1_epi8(21));
+		
+		//lowest priority first, each blend overrides what came before
+		__m256i ranking = _mm256_set1_epi8(NOT_BUST);
+		ranking = _mm256_blendv_epi8(ranking, _mm256_set1_epi8(TWENTYONE), is21);
+		ranking = _mm256_blendv_epi8(ranking, _mm256_set1_epi8(FIVE_CARD_TRICK), _mm256_cmpeq_epi8(size, _mm256_set1_epi8(5)));
+		ranking = _mm256_blendv_epi8(ranking, _mm256_set1_epi8(BLACKJACK), _mm256_and_si256(is21, _mm256_cmpeq_epi8(size, _mm256_set1_epi8(2))));
+		ranking = _mm256_blendv_epi8(ranking, _mm256_set1_epi8(BUST), _mm256_cmpgt_epi8(value, _mm256_set1_epi8(21)));
+		
+		_mm256_storeu_si256((__m256i *)&batch->value[i], value);
+		_mm256_storeu_si256((__m256i *)&batch->ranking[i], ranking);
+	}
+}
+#elif defined(__SSE2__)
+//sse2 has no byte blend, mask ? a : b is done with and/andnot/or
+static __m128i selectBytes(__m128i mask, __m128i a, __m128i b){
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static void handBatchResolveSimd(struct handBatch *batch){ //16 hands per instruction
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+	const __m128i ten = _mm_set1_epi8(10);
+	const __m128i twelve = _mm_set1_epi8(12);
+	const __m128i thirteen = _mm_set1_epi8(13);
+	
+	for (int i = 0; i < HAND_BATCH; i += 16){
+		__m128i hard = zero, anyAce = zero, size = zero;
+		for (int slot = 0; slot < 5; slot++){
+			__m128i kind = _mm_loadu_si128((const __m128i *)&batch->cards[slot][i]);
+			for (int k = 0; k < 3; k++){
+				kind = _mm_sub_epi8(kind, _mm_and_si128(_mm_cmpgt_epi8(kind, thirteen), thirteen));
+			}
+			hard = _mm_add_epi8(hard, _mm_min_epu8(kind, ten));
+			anyAce = _mm_or_si128(anyAce, _mm_cmpeq_epi8(kind, one));
+			size = _mm_add_epi8(size, _mm_andnot_si128(_mm_cmpeq_epi8(kind, zero), one));
+		}
+		
+		__m128i soft = _mm_and_si128(anyAce, _mm_cmpgt_epi8(twelve, hard)); //an ace fits as eleven
+		__m128i value = _mm_add_epi8(hard, _mm_and_si128(soft, ten));
+		__m128i is21 = _mm_cmpeq_epi8(value, _mm_set1_epi8(21));
+		
+		//lowest priority first, each select overrides what came before
+		__m128i ranking = _mm_set1_epi8(NOT_BUST);
+		ranking = selectBytes(is21, _mm_set1_epi8(TWENTYONE), ranking);
+		ranking = selectBytes(_mm_cmpeq_epi8(size, _mm_set1_epi8(5)), _mm_set1_epi8(FIVE_CARD_TRICK), ranking);
+		ranking = selectBytes(_mm_and_si128(is21, _mm_cmpeq_epi8(size, _mm_set1_epi8(2))), _mm_set1_epi8(BLACKJACK), ranking);
+		ranking = selectBytes(_mm_cmpgt_epi8(value, _mm_set1_epi8(21)), _mm_set1_epi8(BUST), ranking);
+		
+		_mm_storeu_si128((__m128i *)&batch->value[i], value);
+		_mm_storeu_si128((__m128i *)&batch->ranking[i], ranking);
+	}
+}
+#endif
+
+//one hand at a time through handAdd/handValue/handResolve, used where there's no simd and as the reference
+void handBatchResolveScalar(struct handBatch *batch){
+	struct hand hand;
+	for (int i = 0; i < HAND_BATCH; i++){
+		handEmpty(&hand);
+		for (int slot = 0; slot < 5 && batch->cards[slot][i] != 0; slot++){
+			struct card cardIn = {batch->cards[slot][i]};
+			handAdd(&hand, cardIn);
+		}
+		batch->value[i] = handValue(&hand);
+		batch->ranking[i] = handResolve(&hand);
+	}
+}
+
+void handBatchResolve(struct handBatch *batch){
+#if defined(__AVX2__) || defined(__SSE2__)
+	handBatchResolveSimd(batch);
+#else
+	handBatchResolveScalar(batch);
+#endif
+}
+
+
+//starts a fresh game, the caller sets the player's name
+void gameNew(struct game *g){
+	g->player.score = 0;
+	g->vars.money = 100;
+	g->vars.handNumber = 0;
+	g->vars.drawPosition = 0;
+	g->vars.initialBet = 0;
+	g->vars.totalBet = 0;
+	g->vars.firstBuy = -1;
+	g->vars.gameState = 0;
+	g->roundResult = 0;
+	
+	//populating the shoe, it gets shuffled as it's drawn
+	shoeFill(&g->shoe, g->decks, g->penetration);
+	
+	//generating empty player and dealer hand
+	resetCards(&g->playerHand, &g->dealerHand);
+}
+
+//state 0: sets new round variables, reshuffles if the cut card came out last round and deals one card each
+void gameDealFirst(struct game *g){
+	if (shoeCutReached(&g->shoe, g->vars.drawPosition)){
+		g->vars.drawPosition = 0; //every card is back in play, shoeDraw does the shuffling
+	}
+	g->vars.initialBet = 0;
+	g->vars.totalBet = 0;
+	g->vars.firstBuy = -1;
+	g->vars.handNumber++;
+	g->roundResult = 0;
+	resetCards(&g->playerHand, &g->dealerHand);
+	
+	topDraw(&g->playerHand, &g->shoe, &g->vars.drawPosition, &g->rng);
+	topDraw(&g->dealerHand, &g->shoe, &g->vars.drawPosition, &g->rng);
+}
+
+//state 0: places the initial bet and deals the second cards
+void gamePlaceBet(struct game *g, int bet){
+	g->vars.initialBet = bet;
+	g->vars.totalBet += bet;
+	
+	topDraw(&g->playerHand, &g->shoe, &g->vars.drawPosition, &g->rng);
+	topDraw(&g->dealerHand, &g->shoe, &g->vars.drawPosition, &g->rng);
+	g->vars.gameState = 1;
+}
+
+//state 1: checking if dealer or player has blackjack
+enum roundEventEnum gameCheckBlackjack(struct game *g){
+	return rulesCheckBlackjack(g, HOUSE_RULES);
+}
+
+RULES_INLINE enum roundEventEnum rulesCheckBlackjack(struct game *g, RULES_PARAMS){
+	enum handRankingEnum dealerRanking = rulesResolve(&g->dealerHand, RULES_ARGS);
+	enum handRankingEnum playerRanking = rulesResolve(&g->playerHand, RULES_ARGS);
+	
+	if (dealerRanking == BLACKJACK && playerRanking == BLACKJACK){ //both blackjack, nothing won or lost
+		g->vars.gameState = 6;
+		return EVENT_BOTH_BLACKJACK;
+	} else if (dealerRanking == BLACKJACK){ //only dealer has blackjack, player loses what blackjack pays (twice the bet)
+		g->roundResult = -blackjackPays*g->vars.initialBet;
+		g->vars.money += g->roundResult;
+		g->vars.gameState = 6;
+		return EVENT_DEALER_BLACKJACK;
+	} else if (playerRanking == BLACKJACK){ //player blackjack goes straight to resolving hand
+		g->vars.gameState = 3;
+	} else{
+		g->vars.gameState = 2; //neither have blackjack, going to player turn
+	}
+	return EVENT_NONE;
+}
+
+//first buy of a round is between initialBet and 2x initialBet, later buys can't exceed the first
+void gameBuyLimits(const struct game *g, int *lower, int *upper){
+	*lower = g->vars.initialBet;
+	if (g->vars.firstBuy == -1){
+		*upper = 2*g->vars.initialBet;
+	} else{
+		*upper = g->vars.firstBuy;
+	}
+}
+
+//state 2: buy, amount must be within gameBuyLimits
+void gameBuy(struct game *g, int amount){
+	if (g->vars.firstBuy == -1){ //setting first buy if appropriate
+		g->vars.firstBuy = amount;
+	}
+	g->vars.totalBet += amount;
+	topDraw(&g->playerHand, &g->shoe, &g->vars.drawPosition, &g->rng);
+	g->vars.gameState = 3;
+}
+
+//state 2: twist
+void gameTwist(struct game *g){
+	topDraw(&g->playerHand, &g->shoe, &g->vars.drawPosition, &g->rng);
+	g->vars.gameState = 3;
+}
+
+//state 2: stick
+void gameStick(struct game *g){
+	g->vars.gameState = 4;
+}
+
+//state 3: resolving player turn, behaviour varies based on rank
+enum roundEventEnum gameResolvePlayer(struct game *g){
+	return rulesResolvePlayer(g, HOUSE_RULES);
+}
+
+RULES_INLINE enum roundEventEnum rulesResolvePlayer(struct game *g, RULES_PARAMS){
+	switch (rulesResolve(&g->playerHand, RULES_ARGS)){
+		case BLACKJACK: //player cannot take more cards, dealer's turn
+			g->vars.gameState = 4;
+			return EVENT_PLAYER_BLACKJACK;
+		case FIVE_CARD_TRICK:
+			g->vars.gameState = 4;
+			return EVENT_PLAYER_FIVE_CARD_TRICK;
+		case TWENTYONE:
+			g->vars.gameState = 4;
+			return EVENT_PLAYER_TWENTYONE;
+		case NOT_BUST: //player can take more cards, takes another turn
+			g->vars.gameState = 2;
+			return EVENT_NONE;
+		default: //player goes bust and loses the round
+			g->roundResult = -g->vars.totalBet;
+			g->vars.money += g->roundResult;
+			g->vars.gameState = 6;
+			return EVENT_PLAYER_BUST;
+	}
+}
+
+int gameDealerMustDraw(const struct game *g){ //dealer must hit below 17
+	return rulesDealerMustDraw(&g->dealerHand, HOUSE_RULES);
+}
+
+//soft 17 is an ace counted as eleven plus six more, a hard total of 7
+RULES_INLINE int rulesDealerMustDraw(const struct hand *dealer, RULES_PARAMS){
+	(void)trickCards; (void)blackjackPays; (void)trickPays;
+	return handValue(dealer) < 17 || (hitSoft17 && dealer->aces > 0 && dealer->hardTotal == 7);
+}
+
+//state 4: dealer sticks on 17 or more, otherwise draws one card
+//anything that isn't "not bust" after a draw (blackjack, FCT, 21, or BUST) goes to resolve hands
+enum roundEventEnum gameDealerTurn(struct game *g){
+	return rulesDealerTurn(g, HOUSE_RULES);
+}
+
+RULES_INLINE enum roundEventEnum rulesDealerTurn(struct game *g, RULES_PARAMS){
+	if (!rulesDealerMustDraw(&g->dealerHand, RULES_ARGS)){
+		g->vars.gameState = 5;
+		return EVENT_DEALER_STICKS;
+	}
+	
+	topDraw(&g->dealerHand, &g->shoe, &g->vars.drawPosition, &g->rng);
+	if (rulesResolve(&g->dealerHand, RULES_ARGS) != NOT_BUST){
+		g->vars.gameState = 5;
+	}
+	return EVENT_DEALER_DRAWS;
+}
+
+//state 5: resolving both hands, ties go to the dealer
+enum roundEventEnum gameSettle(struct game *g){
+	return rulesSettle(g, HOUSE_RULES);
+}
+
+RULES_INLINE enum roundEventEnum rulesSettle(struct game *g, RULES_PARAMS){
+	enum roundEventEnum event = rulesPayout(&g->playerHand, &g->dealerHand, g->vars.totalBet, &g->roundResult, RULES_ARGS);
+	g->vars.money += g->roundResult;
+	if (g->roundResult > 0){ //only winnings count towards score
+		g->player.score += g->roundResult;
+	}
+	g->vars.gameState = 6;
+	return event;
+}
+
+//what a finished player hand wins (+) or loses (-) against the dealer's, a game's or a table seat's
+RULES_INLINE enum roundEventEnum rulesPayout(const struct hand *player, const struct hand *dealer, long bet, long *result, RULES_PARAMS){
+	enum handRankingEnum dealerRanking = rulesResolve(dealer, RULES_ARGS);
+	enum handRankingEnum playerRanking = rulesResolve(player, RULES_ARGS);
+	enum roundEventEnum event;
+	
+	if (dealerRanking == BUST){ //dealer bust, player wins
+		*result = bet;
+		event = EVENT_DEALER_BUST;
+	} else if (dealerRanking == FIVE_CARD_TRICK){ //dealer FCT, player only wins on blackjack
+		if (playerRanking == BLACKJACK){
+			*result = blackjackPays*bet;
+			event = EVENT_BLACKJACK_BEATS_TRICK;
+		} else if (playerRanking == FIVE_CARD_TRICK){
+			*result = -trickPays*bet;
+			event = EVENT_TRICK_BEATS_TRICK;
+		} else{
+			*result = -trickPays*bet;
+			event = EVENT_TRICK_BEATS_HAND;
+		}
+	} else{ //dealer gets 21 or less, player only wins of blackjack, FCT or a higher hand
+		if (playerRanking == BLACKJACK){
+			*result = blackjackPays*bet;
+			event = EVENT_BLACKJACK_WINS;
+		} else if (playerRanking == FIVE_CARD_TRICK){
+			*result = trickPays*bet;
+			event = EVENT_TRICK_WINS;
+		} else if (handValue(player) > handValue(dealer)){
+			*result = bet;
+			event = EVENT_HAND_WINS;
+		} else{
+			*result = -bet;
+			event = EVENT_DEALER_WINS;
+		}
+	}
+	return event;
+}
+
+int gameIsOver(const struct game *g){ //state 6: no money left
+	return g->vars.money <= 0;
+}
+
+//plays one whole round without any I/O, the policy makes every decision the player would
+long gamePlayRound(struct game *g, playerPolicy policy, void *context){
+	return rulesPlayRound(g, policy, context, HOUSE_RULES);
+}
+
+RULES_INLINE long rulesPlayRound(struct game *g, playerPolicy policy, void *context, RULES_PARAMS){
+	int lower, upper;
 	
-	else return 0; //error enum, shouldn't occur
+	gameDealFirst(g);
+	gamePlaceBet(g, policy(g, DECIDE_BET, 1, 10, context));
+	
+	while (g->vars.gameState != 6){
+		switch (g->vars.gameState){
+			case 1:
+				rulesCheckBlackjack(g, RULES_ARGS);
+				break;
+			case 2:
+				switch (policy(g, DECIDE_ACTION, BUY, STICK, context)){
+					case BUY:
+						gameBuyLimits(g, &lower, &upper);
+						gameBuy(g, policy(g, DECIDE_BUY, lower, upper, context));
+						break;
+					case TWIST:
+						gameTwist(g);
+						break;
+					default:
+						gameStick(g);
+						break;
+				}
+				break;
+			case 3:
+				rulesResolvePlayer(g, RULES_ARGS);
+				break;
+			case 4:
+				rulesDealerTurn(g, RULES_ARGS);
+				break;
+			case 5:
+				rulesSettle(g, RULES_ARGS);
+				break;
+		}
+	}
+	return g->roundResult;
+}
+
+//tables: each seat goes through the same states as a game, but the cards all come from the table's shoe and
+//the dealer's hand is played once, after every seat has finished, and settled against every seat still in
+
+//fresh shoe with the cut card far enough in for a round at every seat, full bankroll at every seat
+void tableNew(struct table *t, int seats, int decks, int penetration){
+	t->seats = seats < 1 ? 1 : seats > TABLE_SEATS ? TABLE_SEATS : seats;
+	shoeFill(&t->shoe, decks, penetration);
+	if (t->shoe.cut > 52 * t->shoe.decks - (t->seats + 1) * TRICK_MAX) //every seat and the dealer filling up
+		t->shoe.cut = 52 * t->shoe.decks - (t->seats + 1) * TRICK_MAX;
+	if (t->shoe.cut < 1)
+		t->shoe.cut = 1;
+	t->drawPosition = 0;
+	t->turn = 0;
+	t->state = 0;
+	t->rounds = 0;
+	t->shuffles = 1;
+	t->dealerTurns = 0;
+	handEmpty(&t->dealerHand);
+	for (int i = 0; i < t->seats; i++){
+		struct seat *seat = &t->seat[i];
+		seat->player.score = 0;
+		seat->vars.money = 100;
+		seat->vars.handNumber = 0;
+		seat->vars.drawPosition = 0;
+		seat->vars.initialBet = 0;
+		seat->vars.totalBet = 0;
+		seat->vars.firstBuy = -1;
+		seat->vars.gameState = 0;
+		seat->roundResult = 0;
+		handEmpty(&seat->hand);
+	}
+}
+
+//state 0: reshuffles if the cut card came out last round, then one card to each seat in turn and one to the dealer
+void tableDealFirst(struct table *t){
+	if (shoeCutReached(&t->shoe, t->drawPosition)){
+		t->drawPosition = 0;
+		t->shuffles++;
+	}
+	t->rounds++;
+	t->turn = 0;
+	t->state = 0;
+	handEmpty(&t->dealerHand);
+	for (int i = 0; i < t->seats; i++){
+		struct seat *seat = &t->seat[i];
+		seat->vars.initialBet = 0;
+		seat->vars.totalBet = 0;
+		seat->vars.firstBuy = -1;
+		seat->vars.handNumber++;
+		seat->vars.gameState = 0;
+		seat->roundResult = 0;
+		handEmpty(&seat->hand);
+		topDraw(&seat->hand, &t->shoe, &t->drawPosition, &t->rng);
+	}
+	topDraw(&t->dealerHand, &t->shoe, &t->drawPosition, &t->rng);
+}
+
+void tablePlaceBet(struct table *t, int seat, int bet){
+	rulesTablePlaceBet(t, seat, bet, HOUSE_RULES);
+}
+
+//the first seat from "from" on that still has to play, the dealer's turn if there isn't one, or the end of the
+//round if everyone went bust
+static void tableNextTurn(struct table *t, int from){
+	int waiting = 0;
+	for (int i = 0; i < t->seats; i++){
+		waiting |= t->seat[i].vars.gameState == 4;
+	}
+	for (t->turn = from; t->turn < t->seats; t->turn++){
+		if (t->seat[t->turn].vars.gameState == 2){
+			t->state = 2;
+			return;
+		}
+	}
+	t->state = waiting ? 4 : 6;
+}
+
+//state 0: the seat's initial bet, once the last one is in the second cards go round and blackjacks are checked
+//a dealer blackjack ends the round for everyone, a seat's blackjack just waits for the dealer
+RULES_INLINE void rulesTablePlaceBet(struct table *t, int seat, int bet, RULES_PARAMS){
+	t->seat[seat].vars.initialBet = bet;
+	t->seat[seat].vars.totalBet = bet;
+	t->seat[seat].vars.gameState = 1;
+	for (int i = 0; i < t->seats; i++){
+		if (t->seat[i].vars.gameState != 1)
+			return;
+	}
+	
+	for (int i = 0; i < t->seats; i++){
+		topDraw(&t->seat[i].hand, &t->shoe, &t->drawPosition, &t->rng);
+	}
+	topDraw(&t->dealerHand, &t->shoe, &t->drawPosition, &t->rng);
+	int dealerBlackjack = rulesResolve(&t->dealerHand, RULES_ARGS) == BLACKJACK;
+	for (int i = 0; i < t->seats; i++){
+		struct seat *s = &t->seat[i];
+		int playerBlackjack = rulesResolve(&s->hand, RULES_ARGS) == BLACKJACK;
+		if (dealerBlackjack){ //same as a game's state 1: both blackjack is a push, otherwise what blackjack pays is lost
+			s->roundResult = playerBlackjack ? 0 : -blackjackPays*s->vars.initialBet;
+			s->vars.money += s->roundResult;
+			s->vars.gameState = 6;
+		} else{
+			s->vars.gameState = playerBlackjack ? 4 : 2;
+		}
+	}
+	tableNextTurn(t, 0);
+}
+
+//state 2: buy, twist and stick are the game's, for the seat whose turn it is
+void tableBuy(struct table *t, int amount){
+	struct seat *s = &t->seat[t->turn];
+	if (s->vars.firstBuy == -1){
+		s->vars.firstBuy = amount;
+	}
+	s->vars.totalBet += amount;
+	topDraw(&s->hand, &t->shoe, &t->drawPosition, &t->rng);
+	s->vars.gameState = 3;
+	t->state = 3;
+}
+
+void tableTwist(struct table *t){
+	topDraw(&t->seat[t->turn].hand, &t->shoe, &t->drawPosition, &t->rng);
+	t->seat[t->turn].vars.gameState = 3;
+	t->state = 3;
+}
+
+void tableStick(struct table *t){
+	t->seat[t->turn].vars.gameState = 4;
+	tableNextTurn(t, t->turn + 1);
+}
+
+void tableResolveSeat(struct table *t){
+	rulesTableResolveSeat(t, HOUSE_RULES);
+}
+
+//state 3: the seat plays on, waits for the dealer (blackjack, trick or 21) or goes bust, as in a game
+RULES_INLINE void rulesTableResolveSeat(struct table *t, RULES_PARAMS){
+	struct seat *s = &t->seat[t->turn];
+	switch (rulesResolve(&s->hand, RULES_ARGS)){
+		case NOT_BUST:
+			s->vars.gameState = 2;
+			t->state = 2;
+			return;
+		case BUST:
+			s->roundResult = -s->vars.totalBet;
+			s->vars.money += s->roundResult;
+			s->vars.gameState = 6;
+			break;
+		default:
+			s->vars.gameState = 4;
+			break;
+	}
+	tableNextTurn(t, t->turn + 1);
+}
+
+void tableDealerPlay(struct table *t){
+	rulesTableDealerPlay(t, HOUSE_RULES);
+}
+
+//state 4: the dealer's draws as in a game, all at once since no seat has anything to decide
+RULES_INLINE void rulesTableDealerPlay(struct table *t, RULES_PARAMS){
+	while (rulesDealerMustDraw(&t->dealerHand, RULES_ARGS)){
+		topDraw(&t->dealerHand, &t->shoe, &t->drawPosition, &t->rng);
+		if (rulesResolve(&t->dealerHand, RULES_ARGS) != NOT_BUST)
+			break;
+	}
+	t->dealerTurns++;
+	t->state = 5;
+}
+
+void tableSettle(struct table *t){
+	rulesTableSettle(t, HOUSE_RULES);
+}
+
+//state 5: the one dealer hand against every seat that's waiting on it
+RULES_INLINE void rulesTableSettle(struct table *t, RULES_PARAMS){
+	for (int i = 0; i < t->seats; i++){
+		struct seat *s = &t->seat[i];
+		if (s->vars.gameState != 4)
+			continue;
+		rulesPayout(&s->hand, &t->dealerHand, s->vars.totalBet, &s->roundResult, RULES_ARGS);
+		s->vars.money += s->roundResult;
+		if (s->roundResult > 0){
+			s->player.score += s->roundResult;
+		}
+		s->vars.gameState = 6;
+	}
+	t->state = 6;
+}
+
+//copies the seat into the table's view, good until the next call
+const struct game *tableView(struct table *t, int seat){
+	struct game *view = &t->view;
+	view->player = t->seat[seat].player;
+	view->playerHand = t->seat[seat].hand;
+	view->dealerHand = t->dealerHand;
+	view->vars = t->seat[seat].vars;
+	view->vars.drawPosition = t->drawPosition;
+	view->roundResult = t->seat[seat].roundResult;
+	return view;
+}
+
+long tablePlayRound(struct table *t, playerPolicy policy, void *context){
+	return rulesTablePlayRound(t, policy, context, HOUSE_RULES);
+}
+
+RULES_INLINE long rulesTablePlayRound(struct table *t, playerPolicy policy, void *context, RULES_PARAMS){
+	int lower, upper;
+	
+	tableDealFirst(t);
+	for (int i = 0; i < t->seats; i++){
+		rulesTablePlaceBet(t, i, policy(tableView(t, i), DECIDE_BET, 1, 10, context), RULES_ARGS);
+	}
+	
+	while (t->state == 2){
+		const struct game *view = tableView(t, t->turn);
+		switch (policy(view, DECIDE_ACTION, BUY, STICK, context)){
+			case BUY:
+				gameBuyLimits(view, &lower, &upper);
+				tableBuy(t, policy(view, DECIDE_BUY, lower, upper, context));
+				rulesTableResolveSeat(t, RULES_ARGS);
+				break;
+			case TWIST:
+				tableTwist(t);
+				rulesTableResolveSeat(t, RULES_ARGS);
+				break;
+			default:
+				tableStick(t);
+				break;
+		}
+	}
+	if (t->state == 4){
+		rulesTableDealerPlay(t, RULES_ARGS);
+		rulesTableSettle(t, RULES_ARGS);
+	}
+	
+	long total = 0;
+	for (int i = 0; i < t->seats; i++){
+		total += t->seat[i].roundResult;
+	}
+	return total;
+}
+
+//one specialized round per variant, every rule is a constant inside
+#define RULES_ROUND(id, name, trick, soft17, blackjack, trick2, description) \
+static long rulesRound_##id(struct game *g, playerPolicy policy, void *context){ \
+	return rulesPlayRound(g, policy, context, trick, soft17, blackjack, trick2); \
+} \
+static long rulesTableRound_##id(struct table *t, playerPolicy policy, void *context){ \
+	return rulesTablePlayRound(t, policy, context, trick, soft17, blackjack, trick2); \
+}
+RULE_VARIANTS(RULES_ROUND)
+
+#define RULES_ENTRY(id, name, trick, soft17, blackjack, trick2, description) \
+	{name, trick, soft17, blackjack, trick2, description, rulesRound_##id, rulesTableRound_##id},
+static const struct rules ruleVariants[] = {RULE_VARIANTS(RULES_ENTRY)};
+
+const struct rules *rulesFind(const char *name){
+	for (int i = 0; i < (int)(sizeof(ruleVariants) / sizeof(ruleVariants[0])); i++){
+		if (strcmp(ruleVariants[i].name, name) == 0)
+			return &ruleVariants[i];
+	}
+	return NULL;
+}
+
+void rulesList(){
+	for (int i = 0; i < (int)(sizeof(ruleVariants) / sizeof(ruleVariants[0])); i++){
+		printf("  %-14s %s\n", ruleVariants[i].name, ruleVariants[i].description);
+	}
+}
+
+//baseline policy: always bets/buys the minimum and plays the dealer's rule (twist below 17)
+int policyMimicDealer(const struct game *g, enum decisionEnum decision, int lower, int upper, void *context){
+	(void)upper; (void)context;
+	if (decision == DECIDE_ACTION){
+		if (handValue(&g->playerHand) < 17)
+			return TWIST;
+		return STICK;
+	}
+	return lower;
+}
+
+//hands are handed out to threads in batches, but every hand seeds its own rng stream from (seed, hand number)
+//so the totals only depend on the seed, never on the thread count, and any one hand can be replayed
+#define SIM_BATCH 4096
+
+struct simQueue{ //one run of batches per worker, idle workers steal from the others' runs
+	atomic_long next; //next batch to hand out, fetch_add by the owner and by thieves alike
+	long end;
+	char pad[64 - sizeof(atomic_long) - sizeof(long)]; //own cache line, workers hammer these
+};
+
+struct simWorker{ //per-thread totals, only ever written by their own thread so no locks to merge
+	struct simulation *sim;
+	int id;
+	long hands;
+	long staked;
+	long net;
+	long shuffles, dealerTurns; //tables only
+	pthread_t thread;
+	char pad[64];
+};
+
+struct simulation{
+	long hands;
+	unsigned long long seed;
+	int threads;
+	const struct rules *rules;
+	playerPolicy policy;
+	void *policyContext;
+	int seats, decks, penetration; //seats > 0 plays rounds at tables, every batch at its own
+	struct simQueue *queues;
+	struct simWorker *workers;
+};
+
+//takes the next batch from queue q, returns -1 if it's run dry
+static long simTakeBatch(struct simQueue *q){
+	if (atomic_load_explicit(&q->next, memory_order_relaxed) >= q->end)
+		return -1;
+	long batch = atomic_fetch_add_explicit(&q->next, 1, memory_order_relaxed);
+	return batch < q->end ? batch : -1;
+}
+
+//worker thread: drains its own queue, then steals from the others until everything is done
+static void *simWorkerRun(void *arg){
+	struct simWorker *w = arg;
+	struct simulation *sim = w->sim;
+	struct game g;
+	strcpy(g.player.name, "SIM");
+	g.decks = SHOE_DECKS;
+	g.penetration = SHOE_PENETRATION;
+	rngSeed(&g.rng, sim->seed, 0);
+	gameNew(&g);
+	
+	struct table t;
+	
+	for (int k = 0; k < sim->threads; k++){
+		struct simQueue *q = &sim->queues[(w->id + k) % sim->threads];
+		long batch;
+		while ((batch = simTakeBatch(q)) != -1){
+			long first = batch * SIM_BATCH;
+			long last = first + SIM_BATCH < sim->hands ? first + SIM_BATCH : sim->hands;
+			
+			if (sim->seats > 0){ //rounds at one table, one shoe for the whole batch
+				simTableStart(&t, sim->seed, batch, sim->seats, sim->decks, sim->penetration);
+				for (long i = first; i < last; i++){
+					w->net += sim->rules->playTableRound(&t, sim->policy, sim->policyContext);
+					for (int s = 0; s < t.seats; s++)
+						w->staked += t.seat[s].vars.totalBet;
+				}
+				w->hands += (last - first) * t.seats;
+				w->shuffles += t.shuffles;
+				w->dealerTurns += t.dealerTurns;
+				continue;
+			}
+			for (long i = first; i < last; i++){
+				w->net += simPlayHand(&g, sim->seed, i + 1, sim->rules, sim->policy, sim->policyContext);
+				w->staked += g.vars.totalBet;
+			}
+			w->hands += last - first;
+		}
+	}
+	return NULL;
+}
+
+//seeds the hand's own stream (stream 0 is the interactive game's) and starts from a fresh shoe,
+//since the shuffle would otherwise depend on the order the last hand left the shoe in
+long simPlayHand(struct game *g, unsigned long long seed, long hand, const struct rules *rules, playerPolicy policy, void *context){
+	rngSeed(&g->rng, seed, hand);
+	shoeFill(&g->shoe, g->decks, g->penetration);
+	g->vars.drawPosition = 0;
+	return rules->playRound(g, policy, context);
+}
+
+//a batch of rounds is played at one table on the batch's own stream, so a round only depends on the ones before it
+//in its batch and can be replayed by playing those again
+void simTableStart(struct table *t, unsigned long long seed, long batch, int seats, int decks, int penetration){
+	rngSeed(&t->rng, seed, batch + 1);
+	tableNew(t, seats, decks, penetration);
+	for (int i = 0; i < t->seats; i++){
+		snprintf(t->seat[i].player.name, sizeof(t->seat[i].player.name), "SEAT %d", i + 1);
+	}
+}
+
+//regenerates a single hand of a --simulate run directly from its seed and number
+int replayHand(long hand, unsigned long long seed, const struct rules *rules, playerPolicy policy, void *context,
+	int seats, int decks, int penetration){
+	if (hand <= 0){
+		printf("ERROR: --replay needs a hand number from 1\n");
+		return(1);
+	}
+	
+	if (seats > 0){ //the rounds of its batch up to this one, then every seat's hand
+		struct table t;
+		simTableStart(&t, seed, (hand - 1) / SIM_BATCH, seats, decks, penetration);
+		long result = 0;
+		for (long i = (hand - 1) / SIM_BATCH * SIM_BATCH; i < hand; i++)
+			result = rules->playTableRound(&t, policy, context);
+		
+		printf("seed %llu, round %ld, %s rules, %d seat%s\n", seed, hand, rules->name, t.seats, t.seats == 1 ? "" : "s");
+		screenClear();
+		SCREEN_LITERAL("DEALER'S HAND:\n");
+		displayHand(&t.dealerHand);
+		for (int i = 0; i < t.seats; i++){
+			screenString(t.seat[i].player.name);
+			SCREEN_LITERAL(":\n");
+			displayHand(&t.seat[i].hand);
+		}
+		fwrite(screen.text, 1, screen.length, stdout);
+		screenClear();
+		for (int i = 0; i < t.seats; i++)
+			printf("%s: bet $%d, result %+ld\n", t.seat[i].player.name, t.seat[i].vars.totalBet, t.seat[i].roundResult);
+		printf("table result %+ld\n", result);
+		return(0);
+	}
+	
+	struct game g;
+	strcpy(g.player.name, "SIM");
+	g.decks = SHOE_DECKS;
+	g.penetration = SHOE_PENETRATION;
+	rngSeed(&g.rng, seed, 0);
+	gameNew(&g);
+	long result = simPlayHand(&g, seed, hand, rules, policy, context);
+	
+	printf("seed %llu, hand %ld, %s rules\n", seed, hand, rules->name);
+	screenClear(); //the hands are written into a frame, printed as plain text
+	SCREEN_LITERAL("DEALER'S HAND:\n");
+	displayHand(&g.dealerHand);
+	SCREEN_LITERAL("YOUR HAND:\n");
+	displayHand(&g.playerHand);
+	fwrite(screen.text, 1, screen.length, stdout);
+	screenClear();
+	printf("bet $%d, result %+ld\n", g.vars.totalBet, result);
+	return(0);
+}
+
+static double wallSeconds(){ //wall clock, clock() adds up cpu time of every thread
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//plays a batch of hands headless over several threads and prints the player's results
+int simulate(long hands, int threads, unsigned long long seed, const struct rules *rules, playerPolicy policy, void *context,
+	int seats, int decks, int penetration){
+	if (hands <= 0 || threads <= 0){
+		printf("ERROR: --simulate needs a number of hands and at least one thread\n");
+		return(1);
+	}
+	
+	struct simulation sim;
+	sim.hands = hands;
+	sim.seed = seed;
+	sim.threads = threads;
+	sim.rules = rules;
+	sim.policy = policy;
+	sim.policyContext = context;
+	sim.seats = seats;
+	sim.decks = decks;
+	sim.penetration = penetration;
+	sim.queues = calloc(threads, sizeof(struct simQueue));
+	sim.workers = calloc(threads, sizeof(struct simWorker));
+	if (sim.queues == NULL || sim.workers == NULL){
+		printf("ERROR: out of memory\n");
+		return(1);
+	}
+	
+	//splitting the batches evenly between the workers to start with
+	long batches = (hands + SIM_BATCH - 1) / SIM_BATCH;
+	for (int i = 0; i < threads; i++){
+		atomic_init(&sim.queues[i].next, batches * i / threads);
+		sim.queues[i].end = batches * (i + 1) / threads;
+		sim.workers[i].sim = &sim;
+		sim.workers[i].id = i;
+	}
+	
+	double start = wallSeconds();
+	for (int i = 1; i < threads; i++){
+		if (pthread_create(&sim.workers[i].thread, NULL, simWorkerRun, &sim.workers[i]) != 0){
+			printf("ERROR: couldn't start thread %d\n", i);
+			return(1);
+		}
+	}
+	simWorkerRun(&sim.workers[0]); //main thread works too
+	for (int i = 1; i < threads; i++){
+		pthread_join(sim.workers[i].thread, NULL);
+	}
+	double seconds = wallSeconds() - start;
+	
+	//merging per-thread totals
+	long played = 0, staked = 0, net = 0, shuffles = 0, dealerTurns = 0;
+	for (int i = 0; i < threads; i++){
+		played += sim.workers[i].hands;
+		staked += sim.workers[i].staked;
+		net += sim.workers[i].net;
+		shuffles += sim.workers[i].shuffles;
+		dealerTurns += sim.workers[i].dealerTurns;
+	}
+	
+	printf("rules:        %s\n", rules->name);
+	printf("seed:         %llu\n", seed);
+	printf("threads:      %d\n", threads);
+	if (seats > 0){
+		printf("seats:        %d (%d decks)\n", seats, decks);
+		printf("rounds:       %ld\n", hands);
+		printf("hands/shoe:   %.1f\n", (double)played / shuffles);
+		printf("dealer plays: %ld (%.3f a hand)\n", dealerTurns, (double)dealerTurns / played);
+	}
+	printf("hands:        %ld\n", played);
+	printf("total staked: %ld\n", staked);
+	printf("net result:   %ld\n", net);
+	printf("return/stake: %.5f\n", (double)net / staked);
+	printf("time:         %.3fs (%.0f hands/s)\n", seconds, seconds > 0 ? played / seconds : 0.0);
+	
+	free(sim.queues);
+	free(sim.workers);
+	return(0);
+}
+
+//the same number of hands dealt the way --simulate does for one player (a fresh shoe every hand) and at tables
+//of 1 to TABLE_SEATS seats sharing a shoe of D decks and one dealer hand a round, single threaded
+int benchTable(long hands, int decks, int penetration, unsigned long long seed){
+	const struct rules *rules = rulesFind("house");
+	struct game g;
+	strcpy(g.player.name, "BENCH");
+	g.decks = SHOE_DECKS;
+	g.penetration = SHOE_PENETRATION;
+	rngSeed(&g.rng, seed, 0);
+	gameNew(&g);
+	struct table t;
+	
+	printf("%ld hands each, tables deal from %d deck%s\n", hands, decks, decks == 1 ? "" : "s");
+	printf("%-18s %10s %12s %14s %14s\n", "", "ns/hand", "hands/shoe", "dealer plays", "return/stake");
+	long staked = 0, net = 0;
+	double start = wallSeconds();
+	for (long i = 0; i < hands; i++){
+		net += simPlayHand(&g, seed, i + 1, rules, policyMimicDealer, NULL);
+		staked += g.vars.totalBet;
+	}
+	double seconds = wallSeconds() - start;
+	printf("%-18s %10.1f %12.1f %14s %14.5f\n", "game, fresh shoe", seconds * 1e9 / hands, 1.0, "-", (double)net / staked);
+	
+	const int seatCounts[] = {1, 2, 4, TABLE_SEATS};
+	for (int k = 0; k < (int)(sizeof(seatCounts) / sizeof(seatCounts[0])); k++){
+		long rounds = hands / seatCounts[k];
+		staked = net = 0;
+		simTableStart(&t, seed, 0, seatCounts[k], decks, penetration);
+		start = wallSeconds();
+		for (long i = 0; i < rounds; i++){
+			net += rules->playTableRound(&t, policyMimicDealer, NULL);
+			for (int s = 0; s < t.seats; s++)
+				staked += t.seat[s].vars.totalBet;
+		}
+		seconds = wallSeconds() - start;
+		
+		char name[24];
+		snprintf(name, sizeof(name), "table, %d seat%s", t.seats, t.seats == 1 ? "" : "s");
+		long played = rounds * t.seats;
+		printf("%-18s %10.1f %12.1f %14.3f %14.5f\n", name, seconds * 1e9 / played, (double)played / t.shuffles,
+			(double)t.dealerTurns / played, (double)net / staked);
+	}
+	return(0);
+}
+
+static unsigned int crcTable[256];
+static pthread_once_t crcTableOnce = PTHREAD_ONCE_INIT;
+
+static void crcTableBuild(void){
+	for (unsigned int i = 0; i < 256; i++){
+		unsigned int c = i;
+		for (int k = 0; k < 8; k++){
+			c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+		}
+		crcTable[i] = c;
+	}
+}
+
+//crc32 (the zip/ethernet one), table built on first use
+//pthread_once because the game, the background saver and the leaderboard merge thread all checksum
+unsigned int crc32(const void *data, long length){
+	pthread_once(&crcTableOnce, crcTableBuild);
+	
+	const unsigned char *bytes = data;
+	unsigned int crc = 0xFFFFFFFFu;
+	for (long i = 0; i < length; i++){
+		crc = crcTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFFu;
+}
+
+//crc of everything after the crc field
+static unsigned int saveChecksum(const struct saveFile *save){
+	const char *start = (const char *)save + offsetof(struct saveFile, crc) + sizeof(save->crc);
+	return crc32(start, sizeof(*save) - (start - (const char *)save));
+}
+
+//version 1 save (one 52 card deck) read into save: becomes a one deck shoe, sealed as the current version
+//if its own crc checks out, otherwise left to fail validFile
+static void saveUpgrade(struct saveFile *save){
+	struct saveFileV1 old;
+	memcpy(&old, save, sizeof(old));
+	memset(save, 0, sizeof(*save));
+	long start = offsetof(struct saveFileV1, crc) + sizeof(old.crc);
+	if (memcmp(old.magic, SAVE_MAGIC, sizeof(old.magic)) != 0 || old.size != (int)sizeof(old)
+		|| old.crc != crc32((const char *)&old + start, sizeof(old) - start))
+		return;
+	
+	memcpy(save->leaderboard, old.leaderboard, sizeof(save->leaderboard));
+	save->current = old.current;
+	shoeFill(&save->shoe, 1, SHOE_PENETRATION);
+	memcpy(save->shoe.cards, old.deck, sizeof(old.deck));
+	memcpy(save->playerCards, old.playerCards, sizeof(save->playerCards));
+	memcpy(save->dealerCards, old.dealerCards, sizeof(save->dealerCards));
+	save->vars = old.vars;
+	sealSave(save);
+}
+
+//reads the whole save in one go, returns 0 if there's no file, otherwise 1 (check it with validFile)
+//a version 1 save is upgraded here, and written back as the current version the next time the game saves
+int readSave(struct saveFile *save, const char *path){
+	FILE *fIn = fopen(path, "rb");
+	if (fIn == NULL)
+		return 0;
+	memset(save, 0, sizeof(*save));
+	size_t got = fread(save, 1, sizeof(*save), fIn);
+	if (got == sizeof(struct saveFileV1) && save->version == 1){
+		saveUpgrade(save);
+	} else if (got != sizeof(*save)){ //short file, fails validFile
+		memset(save, 0, sizeof(*save));
+	}
+	fclose(fIn);
+	return 1;
+}
+
+//O(1): header, version, layout size and crc
+int validFile(const struct saveFile *save){
+	return memcmp(save->magic, SAVE_MAGIC, sizeof(save->magic)) == 0 && save->version == SAVE_VERSION
+		&& save->size == (int)sizeof(*save) && save->crc == saveChecksum(save);
+}
+
+void sealSave(struct saveFile *save){
+	memcpy(save->magic, SAVE_MAGIC, sizeof(save->magic));
+	save->version = SAVE_VERSION;
+	save->size = sizeof(*save);
+	save->crc = saveChecksum(save);
+}
+
+//fills in the header and crc and writes the whole save in one go
+int writeSave(struct saveFile *save, const char *path){
+	sealSave(save);
+	
+	//written next to the old one and renamed over it, so a crash leaves either the old save or the new one
+	char tempPath[JOURNAL_PATH_MAX];
+	snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+	FILE *fOut = fopen(tempPath, "wb");
+	if (fOut == NULL)
+		return 0;
+	int ok = fwrite(save, sizeof(*save), 1, fOut) == 1;
+	ok &= fflush(fOut) == 0 && fsync(fileno(fOut)) == 0;
+	ok &= fclose(fOut) == 0;
+	if (!ok || rename(tempPath, path) != 0){
+		remove(tempPath);
+		return 0;
+	}
+	return 1;
+}
+
+//reads a card saved as a suit line and a kind line
+static struct card loadCard(FILE *fIO){
+	char buffer[100];
+	int suit = 0, kind = 0;
+	
+	if(fgets(buffer, sizeof(buffer), fIO)){
+		suit = atoi(buffer);
+	}
+	if(fgets(buffer, sizeof(buffer), fIO)){
+		kind = atoi(buffer);
+	}
+	return cardMake(suit, kind);
+}
+
+//old text save: exactly 153 lines, one field per line
+static int validTextFile(FILE *fIO){ 
+	int lineNumber = 1; //to ensure matches with row# in textedit
+	int ch;
+	while((ch = fgetc(fIO)) != EOF){
+		if(ch == '\n'){ //if char is newline, increment
+			lineNumber++;
+		}
+	}
+	rewind(fIO);
+	return lineNumber == 154;
+}
+
+//parsing an old text save into save, 0 if it isn't 153 lines
+static int loadTextSave(FILE *fIO, struct saveFile *save){
+	char buffer[100];
+	
+	if (!validTextFile(fIO))
+		return 0;
+	
+	for (int i = 0; i < 10; i++){ //reading leaderboard
+		if(fgets(buffer, sizeof(buffer), fIO)){
+			buffer[strcspn(buffer, "\n")] = '\0';
+			buffer[sizeof(save->leaderboard[i].name) - 1] = '\0'; //names are at most 15 characters
+			strcpy(save->leaderboard[i].name, buffer);
+		}
+		if(fgets(buffer, sizeof(buffer), fIO)){
+			save->leaderboard[i].score = strtol(buffer, NULL, 10);
+		}
+	}
+	
+	if(fgets(buffer, sizeof(buffer), fIO)){ //reading name
+		buffer[strcspn(buffer, "\n")] = '\0';
+		buffer[sizeof(save->current.name) - 1] = '\0';
+		strcpy(save->current.name, buffer);
+	}
+	if(fgets(buffer, sizeof(buffer), fIO)){ //reading score
+		save->current.score = strtol(buffer, NULL, 10);
+	}
+	
+	shoeFill(&save->shoe, 1, SHOE_PENETRATION); //text saves only ever had one deck
+	for(int i = 0; i<52; i++){ //reading deck
+		save->shoe.cards[i] = loadCard(fIO);
+	}
+	for (int i = 0; i < 5; i++){ //reading player and dealer hands
+		save->playerCards[i] = loadCard(fIO);
+		save->dealerCards[i] = loadCard(fIO);
+	}
+	
+	//following vars get read into save->vars
+	if(fgets(buffer, sizeof(buffer), fIO)){ 
+		save->vars.money = strtol(buffer, NULL, 10);
+	}
+	if(fgets(buffer, sizeof(buffer), fIO)){ 
+		save->vars.handNumber = atoi(buffer);
+	}
+	if(fgets(buffer, sizeof(buffer), fIO)){
+		save->vars.drawPosition = atoi(buffer);	
+	}
+	if(fgets(buffer, sizeof(buffer), fIO)){
+		save->vars.initialBet = atoi(buffer);
+	}
+	if(fgets(buffer, sizeof(buffer), fIO)){
+		save->vars.totalBet = atoi(buffer);
+	}
+	if(fgets(buffer, sizeof(buffer), fIO)){
+		save->vars.firstBuy = atoi(buffer);
+	}
+	if(fgets(buffer, sizeof(buffer), fIO)){
+		save->vars.gameState = atoi(buffer);
+	}
+	return 1;
+}
+
+//no save.bin yet: converts save.txt from before the binary format (kept as save.txt.bak),
+//or starts an empty save if there's neither
+int migrateSave(struct saveFile *save){
+	memset(save, 0, sizeof(*save));
+	resetLeaderboard(save->leaderboard);
+	
+	FILE *fIn = fopen(SAVE_TEXT_PATH, "r");
+	if (fIn != NULL){
+		int parsed = loadTextSave(fIn, save);
+		fclose(fIn);
+		if (!parsed){
+			printf("ERROR: \"%s\" LIKELY TAMPERED WITH, not converting it\n", SAVE_TEXT_PATH);
+			return 0;
+		}
+	}
+	if (!writeSave(save, SAVE_PATH)){
+		printf("ERROR: couldn't write \"%s\"\n", SAVE_PATH);
+		return 0;
+	}
+	if (fIn != NULL){
+		rename(SAVE_TEXT_PATH, SAVE_TEXT_PATH ".bak");
+		printf("Converted \"%s\" to \"%s\"\n", SAVE_TEXT_PATH, SAVE_PATH);
+	}
+	return 1;
+}
+
+//loading just the leaderboard
+//called at the start in case player starts new game, only leaderboard carries over
+//a board that's never been used starts from the top 10 kept in the save
+long loadLeaderboard(struct rankShared *board, const struct saveFile *save, struct player *leaderboard){
+	long ranked;
+	resetLeaderboard(leaderboard);
+	rankSharedTop(board, leaderboard, 10, &ranked);
+	if (ranked == 0){
+		for (int i = 0; i < 10; i++){
+			if (save->leaderboard[i].name[0] != '\0')
+				rankSharedSubmit(board, save->leaderboard[i]);
+		}
+		rankSharedMerge(board);
+		rankSharedTop(board, leaderboard, 10, &ranked);
+	}
+	return ranked;
+}
+
+//loading entire game 					//C3: input file 
+void loadGame(const struct saveFile *save, struct player *leaderboard, struct player *currentPlayer, struct shoe *shoe, struct hand *playerHand, struct hand *dealerHand, struct gameVars *loadVars){
+	memcpy(leaderboard, save->leaderboard, sizeof(save->leaderboard));
+	*currentPlayer = save->current;
+	currentPlayer->name[sizeof(currentPlayer->name) - 1] = '\0';
+	*shoe = save->shoe;
+	
+	handEmpty(playerHand);
+	handEmpty(dealerHand);
+	memcpy(playerHand->cards, save->playerCards, sizeof(save->playerCards));
+	memcpy(dealerHand->cards, save->dealerCards, sizeof(save->dealerCards));
+	handRecount(playerHand);
+	handRecount(dealerHand);
+	
+	*loadVars = save->vars;
+	if (shoe->decks < 1 || shoe->decks > SHOE_MAX_DECKS || loadVars->drawPosition < 0 || loadVars->drawPosition > 52 * shoe->decks - 2 * TRICK_MAX){
+		shoeFill(shoe, SHOE_DECKS, SHOE_PENETRATION); //the empty save from migrateSave, there's no shoe in it yet
+		loadVars->drawPosition = 0;
+	}
+}
+
+//function to save current game, one write of the whole file, the cache keeps what was written
+int saveGame(struct saveCache *cache, struct player *leaderboard, struct player currentPlayer, struct shoe *shoe, struct hand *playerHand, struct hand *dealerHand, struct gameVars saveVars){
+	struct saveFile *save = &cache->save;
+	memset(save, 0, sizeof(*save)); //clears the padding too
+	memcpy(save->leaderboard, leaderboard, sizeof(save->leaderboard));
+	save->current = currentPlayer;
+	save->shoe = *shoe;
+	memcpy(save->playerCards, playerHand->cards, sizeof(save->playerCards));
+	memcpy(save->dealerCards, dealerHand->cards, sizeof(save->dealerCards));
+	save->vars = saveVars;
+	
+	if (!saveCacheWrite(cache, SAVE_PATH)){ //background writes report their errors when they're picked up
+		screenPrintf("ERROR: couldn't write \"%s\"\n", SAVE_PATH);
+		return 0;
+	}
+	return 1;
+} 
+
+//writer thread: takes whatever snapshot is pending, writes it, repeats until told to stop with nothing left
+static void *saveWriterRun(void *arg){
+	struct saveWriter *writer = arg;
+	
+	pthread_mutex_lock(&writer->lock);
+	while (1){
+		while (writer->pending < 0 && !writer->stop){
+			pthread_cond_wait(&writer->wake, &writer->lock);
+		}
+		if (writer->pending < 0) //stopping, and nothing left to write
+			break;
+		writer->writing = writer->pending;
+		writer->pending = -1;
+		pthread_mutex_unlock(&writer->lock);
+		
+		//the game only ever fills the other buffer, so this one can be written without the lock
+		struct saveFile *save = &writer->buffers[writer->writing];
+		struct stat st;
+		int ok = writeSave(save, writer->path) && stat(writer->path, &st) == 0;
+		
+		pthread_mutex_lock(&writer->lock);
+		if (ok){
+			writer->crc = save->crc;
+			writer->size = st.st_size;
+			writer->mtime = st.st_mtim;
+		} else{
+			writer->failed++;
+		}
+		writer->writing = -1;
+		writer->completed++;
+		pthread_cond_broadcast(&writer->done);
+	}
+	pthread_mutex_unlock(&writer->lock);
+	return NULL;
+}
+
+int saveWriterStart(struct saveWriter *writer, const char *path){
+	memset(writer, 0, sizeof(*writer));
+	snprintf(writer->path, sizeof(writer->path), "%s", path);
+	writer->pending = -1;
+	writer->writing = -1;
+	pthread_mutex_init(&writer->lock, NULL);
+	pthread_cond_init(&writer->wake, NULL);
+	pthread_cond_init(&writer->done, NULL);
+	if (pthread_create(&writer->thread, NULL, saveWriterRun, writer) != 0){
+		pthread_mutex_destroy(&writer->lock);
+		pthread_cond_destroy(&writer->wake);
+		pthread_cond_destroy(&writer->done);
+		return 0;
+	}
+	return 1;
+}
+
+//hands a copy of save to the writer and returns straight away, a snapshot that's still waiting is replaced
+//(only the newest one matters), otherwise it goes in whichever buffer isn't being written
+void saveWriterSubmit(struct saveWriter *writer, const struct saveFile *save){
+	pthread_mutex_lock(&writer->lock);
+	int slot;
+	if (writer->pending >= 0){
+		slot = writer->pending;
+		writer->coalesced++;
+	} else{
+		slot = writer->writing == 0 ? 1 : 0;
+	}
+	writer->buffers[slot] = *save;
+	writer->pending = slot;
+	writer->submitted++;
+	pthread_cond_signal(&writer->wake);
+	pthread_mutex_unlock(&writer->lock);
+}
+
+//waits until everything submitted is on disk
+void saveWriterFlush(struct saveWriter *writer){
+	pthread_mutex_lock(&writer->lock);
+	while (writer->pending >= 0 || writer->writing >= 0){
+		pthread_cond_wait(&writer->done, &writer->lock);
+	}
+	pthread_mutex_unlock(&writer->lock);
+}
+
+//writes anything still pending, then ends the thread
+void saveWriterStop(struct saveWriter *writer){
+	pthread_mutex_lock(&writer->lock);
+	writer->stop = 1;
+	pthread_cond_signal(&writer->wake);
+	pthread_mutex_unlock(&writer->lock);
+	pthread_join(writer->thread, NULL);
+	pthread_mutex_destroy(&writer->lock);
+	pthread_cond_destroy(&writer->wake);
+	pthread_cond_destroy(&writer->done);
+}
+
+//picks up the results of background writes: the new file's size/mtime so the cache doesn't reload its own write,
+//and its crc so the next journal record starts a journal for it. returns 1 while a write is still pending or running
+static int saveCachePoll(struct saveCache *cache){
+	struct saveWriter *writer = cache->writer;
+	pthread_mutex_lock(&writer->lock);
+	int busy = writer->pending >= 0 || writer->writing >= 0;
+	if (writer->completed != cache->writesSeen){
+		cache->writesSeen = writer->completed;
+		cache->size = writer->size;
+		cache->mtime = writer->mtime;
+		cache->durableCrc = writer->crc;
+	}
+	int failed = writer->failed;
+	writer->failed = 0;
+	pthread_mutex_unlock(&writer->lock);
+	
+	if (failed){
+		printf("ERROR: couldn't write \"%s\"\n", writer->path);
+	}
+	return busy;
+}
+
+//stats the save and only reads it again if its size or modification time changed since the last read/write,
+//returns 0 if there's no save file
+int saveCacheRefresh(struct saveCache *cache, const char *path){
+	struct stat st;
+	if (cache->writer != NULL && saveCachePoll(cache) && cache->loaded) //our own write is still going, memory is newest
+		return 1;
+	cache->stats++;
+	if (stat(path, &st) != 0){
+		cache->loaded = 0;
+		return 0;
+	}
+	if (cache->loaded && st.st_size == cache->size && st.st_mtim.tv_sec == cache->mtime.tv_sec
+		&& st.st_mtim.tv_nsec == cache->mtime.tv_nsec)
+		return 1;
+	
+	cache->reads++;
+	if (!readSave(&cache->save, path))
+		return 0;
+	cache->valid = validFile(&cache->save);
+	cache->loaded = 1;
+	cache->size = st.st_size;
+	cache->mtime = st.st_mtim;
+	cache->durableCrc = cache->save.crc;
+	
+	//hands journaled after the last save (the game didn't get to save and quit), folded in straight away
+	long recovered = cache->valid ? journalReplay(&cache->save, path) : 0;
+	if (recovered > 0){
+		printf("Recovered %ld hand%s from \"%s.journal\"\n", recovered, recovered == 1 ? "" : "s", path);
+		saveCacheWrite(cache, path);
+	}
+	return 1;
+}
+
+//writes the cached save back and remembers the new size/mtime so our own write doesn't cause a reload,
+//the journal starts again empty since the save now has everything in it
+//with a writer this only hands over a snapshot: the journal keeps going until the write is known to be on disk
+int saveCacheWrite(struct saveCache *cache, const char *path){
+	struct stat st;
+	if (cache->writer != NULL){
+		sealSave(&cache->save);
+		cache->valid = 1;
+		saveWriterSubmit(cache->writer, &cache->save);
+		return 1;
+	}
+	
+	if (!writeSave(&cache->save, path))
+		return 0;
+	cache->valid = 1;
+	cache->loaded = stat(path, &st) == 0;
+	cache->size = st.st_size;
+	cache->mtime = st.st_mtim;
+	cache->durableCrc = cache->save.crc;
+	journalReset(&cache->journal, path, cache->durableCrc);
+	return 1;
+}
+
+//journals a finished hand against the cached save (starting the journal if it isn't open for this save yet),
+//returns 1 once there are JOURNAL_COMPACT records and the save should be rewritten
+int saveCacheRecord(struct saveCache *cache, const char *path, struct player player, struct gameVars vars){
+	if (cache->writer != NULL){
+		saveCachePoll(cache);
+	}
+	if (cache->journal.fd < 0 || cache->journal.saveCrc != cache->durableCrc){
+		journalReset(&cache->journal, path, cache->durableCrc);
+	}
+	long records = journalAppend(&cache->journal, player, vars);
+	return records < 0 || records >= JOURNAL_COMPACT;
+}
+
+//at exit: lets the writer finish, and empties the journal if a save written since made it redundant
+void saveCacheClose(struct saveCache *cache, const char *path){
+	if (cache->writer != NULL){
+		saveWriterFlush(cache->writer);
+		saveCachePoll(cache);
+		saveWriterStop(cache->writer);
+		cache->writer = NULL;
+	}
+	if (cache->journal.fd >= 0 && cache->journal.saveCrc != cache->durableCrc){
+		journalReset(&cache->journal, path, cache->durableCrc);
+	}
+	journalClose(&cache->journal);
+}
+
+//journal file that goes with a save file
+static void journalPathFor(char *out, long size, const char *savePath){
+	snprintf(out, size, "%s.journal", savePath);
+}
+
+//starts an empty journal for the save whose crc is saveCrc, anything already in it is thrown away
+int journalReset(struct journal *journal, const char *savePath, unsigned int saveCrc){
+	char path[JOURNAL_PATH_MAX];
+	journalPathFor(path, sizeof(path), savePath);
+	if (journal->fd >= 0)
+		close(journal->fd);
+	
+	journal->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+	journal->records = 0;
+	journal->unsynced = 0;
+	journal->saveCrc = saveCrc;
+	if (journal->fd < 0)
+		return 0;
+	
+	struct journalHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+	header.saveCrc = saveCrc;
+	if (write(journal->fd, &header, sizeof(header)) != sizeof(header) || fsync(journal->fd) != 0){
+		close(journal->fd);
+		journal->fd = -1;
+		return 0;
+	}
+	return 1;
+}
+
+//appends one record, only fsyncing every JOURNAL_SYNC_EVERY records (a crash of the program loses nothing
+//once write returns, a power cut can lose the unsynced ones), returns the records in the journal or -1
+long journalAppend(struct journal *journal, struct player player, struct gameVars vars){
+	if (journal->fd < 0)
+		return -1;
+	
+	struct journalRecord record;
+	memset(&record, 0, sizeof(record)); //clears the padding too
+	record.sequence = journal->records + 1;
+	record.player = player;
+	record.vars = vars;
+	record.crc = crc32((const char *)&record + sizeof(record.crc), sizeof(record) - sizeof(record.crc));
+	
+	if (write(journal->fd, &record, sizeof(record)) != sizeof(record))
+		return -1;
+	journal->records++;
+	if (++journal->unsynced >= JOURNAL_SYNC_EVERY){
+		fsync(journal->fd);
+		journal->unsynced = 0;
+	}
+	return journal->records;
+}
+
+//syncs whatever hasn't been yet and closes the journal
+void journalClose(struct journal *journal){
+	if (journal->fd < 0)
+		return;
+	if (journal->unsynced > 0)
+		fsync(journal->fd);
+	close(journal->fd);
+	journal->fd = -1;
+}
+
+//applies the save's journal on top of it: every record is the player and game vars after a hand, so the last
+//good one wins. stops at the first torn or corrupt record, and ignores a journal written for a different
+//snapshot (left over if a crash came between writing save.bin and starting its new journal)
+//returns the number of records applied
+long journalReplay(struct saveFile *save, const char *savePath){
+	char path[JOURNAL_PATH_MAX];
+	journalPathFor(path, sizeof(path), savePath);
+	FILE *fIn = fopen(path, "rb");
+	if (fIn == NULL)
+		return 0;
+	
+	struct journalHeader header;
+	struct journalRecord record;
+	long applied = 0;
+	if (fread(&header, sizeof(header), 1, fIn) == 1 && memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) == 0
+		&& header.saveCrc == save->crc){
+		while (fread(&record, sizeof(record), 1, fIn) == 1){
+			if (record.sequence != applied + 1
+				|| record.crc != crc32((const char *)&record + sizeof(record.crc), sizeof(record) - sizeof(record.crc)))
+				break;
+			save->current = record.player;
+			save->vars = record.vars; //the shoe isn't journaled: it carries on as if the cards since save.bin were the next ones in it
+			applied++;
+		}
+	}
+	fclose(fIn);
+	
+	if (applied > 0){ //the journal is only written between hands, the next deal starts from empty hands
+		memset(save->playerCards, 0, sizeof(save->playerCards));
+		memset(save->dealerCards, 0, sizeof(save->dealerCards));
+	}
+	return applied;
+}
+
+//FNV-1a over the name up to its terminator
+static unsigned long long profileHash(const char *name){
+	unsigned long long h = 1469598103934665603ULL;
+	for (int i = 0; i < PROFILE_NAME && name[i] != '\0'; i++){
+		h = (h ^ (unsigned char)name[i]) * 1099511628211ULL;
+	}
+	return h;
+}
+
+static int *profileBuckets(const struct profileStore *store){
+	return (int *)((char *)store->map + sizeof(struct profileHeader));
+}
+
+static struct profileSlot *profileSlotAt(const struct profileStore *store, int slot){
+	long bucketBytes = store->header->capacity * (long)sizeof(int);
+	return (struct profileSlot *)((char *)store->map + sizeof(struct profileHeader) + bucketBytes) + slot;
+}
+
+//crc of the profile itself, next and inUse change as other profiles come and go so they're left out
+static unsigned int profileChecksum(const struct profileSlot *slot){
+	long start = offsetof(struct profileSlot, crc) + sizeof(slot->crc);
+	return crc32((const char *)slot + start, sizeof(*slot) - start);
+}
+
+static long profileFileSize(long capacity){
+	return sizeof(struct profileHeader) + capacity * (long)sizeof(int) + capacity * (long)sizeof(struct profileSlot);
+}
+
+//maps path, making an empty store of the given capacity first if it doesn't exist (or capacity is set and it's a rebuild)
+static int profileMap(struct profileStore *store, const char *path, long createCapacity){
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return 0;
+	
+	struct stat st;
+	if (fstat(fd, &st) != 0){
+		close(fd);
+		return 0;
+	}
+	if (st.st_size == 0){ //new store, every bucket starts empty
+		if (ftruncate(fd, profileFileSize(createCapacity)) != 0){
+			close(fd);
+			return 0;
+		}
+		st.st_size = profileFileSize(createCapacity);
+	}
+	
+	void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED){
+		close(fd);
+		return 0;
+	}
+	
+	struct profileHeader *header = map;
+	if (header->magic[0] == '\0'){ //fresh file (ftruncate zero fills), only the header and buckets get written
+		memcpy(header->magic, PROFILE_MAGIC, sizeof(header->magic));
+		header->version = PROFILE_VERSION;
+		header->slotSize = sizeof(struct profileSlot);
+		header->capacity = createCapacity;
+		header->used = 0;
+		header->freeHead = -1;
+		header->nextUnused = 0;
+		memset((char *)map + sizeof(struct profileHeader), 0xFF, createCapacity * sizeof(int)); //-1 everywhere
+	}
+	if (memcmp(header->magic, PROFILE_MAGIC, sizeof(header->magic)) != 0 || header->version != PROFILE_VERSION
+		|| header->slotSize != (int)sizeof(struct profileSlot) || profileFileSize(header->capacity) != st.st_size){
+		munmap(map, st.st_size);
+		close(fd);
+		return 0;
+	}
+	
+	store->fd = fd;
+	store->map = map;
+	store->mapSize = st.st_size;
+	store->header = header;
+	store->inode = st.st_ino;
+	return 1;
+}
+
+static void profileUnmap(struct profileStore *store){
+	if (store->map != NULL){
+		munmap(store->map, store->mapSize);
+		close(store->fd);
+	}
+	store->map = NULL;
+	store->header = NULL;
+	store->fd = -1;
+}
+
+//profiles.db from before the shoe: every profile copied into a new store, which is renamed over the old one
+static int profileUpgrade(const char *path){
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	struct profileHeader header;
+	if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || memcmp(header.magic, PROFILE_MAGIC, sizeof(header.magic)) != 0
+		|| header.version != 1 || header.slotSize != (int)sizeof(struct profileSlotV1)){
+		close(fd);
+		return 0;
+	}
+	
+	char tempPath[JOURNAL_PATH_MAX + 4];
+	snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+	remove(tempPath);
+	struct profileStore upgraded;
+	if (!profileStoreOpen(&upgraded, tempPath)){
+		close(fd);
+		return 0;
+	}
+	
+	struct game g;
+	memset(&g, 0, sizeof(g));
+	off_t slots = sizeof(header) + header.capacity * sizeof(int);
+	long start = offsetof(struct profileSlotV1, crc) + sizeof(unsigned int);
+	int ok = 1;
+	for (int i = 0; i < header.nextUnused && ok; i++){
+		struct profileSlotV1 old;
+		if (pread(fd, &old, sizeof(old), slots + (off_t)i * sizeof(old)) != sizeof(old)){
+			ok = 0;
+		} else if (old.inUse && old.crc == crc32((const char *)&old + start, sizeof(old) - start)){ //damaged ones are dropped
+			g.player = old.player;
+			g.vars = old.vars;
+			shoeFill(&g.shoe, 1, SHOE_PENETRATION);
+			memcpy(g.shoe.cards, old.deck, sizeof(old.deck));
+			memcpy(g.playerHand.cards, old.playerCards, sizeof(old.playerCards));
+			memcpy(g.dealerHand.cards, old.dealerCards, sizeof(old.dealerCards));
+			ok = profileSave(&upgraded, &g);
+		}
+	}
+	close(fd);
+	profileStoreClose(&upgraded);
+	if (!ok || rename(tempPath, path) != 0){
+		remove(tempPath);
+		return 0;
+	}
+	return 1;
+}
+
+int profileStoreOpen(struct profileStore *store, const char *path){
+	memset(store, 0, sizeof(*store));
+	store->fd = -1;
+	snprintf(store->path, sizeof(store->path), "%s", path);
+	if (profileMap(store, path, PROFILE_START_CAPACITY))
+		return 1;
+	return profileUpgrade(path) && profileMap(store, path, PROFILE_START_CAPACITY);
+}
+
+void profileStoreClose(struct profileStore *store){
+	profileUnmap(store);
+}
+
+//locks the store against other processes sharing it, picking up a store another process has rebuilt bigger
+//(rebuilds are renamed into place, so the old mapping is a different file to the one at path now)
+static int profileLock(struct profileStore *store, int exclusive){
+	for (int tries = 0; tries < 8; tries++){
+		if (store->map == NULL && !profileMap(store, store->path, PROFILE_START_CAPACITY))
+			return 0;
+		flock(store->fd, exclusive ? LOCK_EX : LOCK_SH);
+		
+		struct stat st;
+		if (stat(store->path, &st) == 0 && st.st_ino == store->inode)
+			return 1;
+		flock(store->fd, LOCK_UN);
+		profileUnmap(store);
+	}
+	return 0;
+}
+
+static void profileUnlock(struct profileStore *store){
+	flock(store->fd, LOCK_UN);
+}
+
+//slot holding name, -1 if there isn't one: one bucket read, then a short chain
+static int profileFindSlot(const struct profileStore *store, const char *name){
+	int slot = profileBuckets(store)[profileHash(name) % store->header->capacity];
+	while (slot >= 0){
+		struct profileSlot *s = profileSlotAt(store, slot);
+		if (strncmp(s->player.name, name, PROFILE_NAME) == 0)
+			return slot;
+		slot = s->next;
+	}
+	return -1;
+}
+
+//twice the slots and buckets, built in a new file and renamed over the old one
+//every profile is touched once, so it's O(1) spread over the inserts that filled the store
+static int profileGrow(struct profileStore *store){
+	char tempPath[sizeof(store->path) + 4];
+	snprintf(tempPath, sizeof(tempPath), "%s.tmp", store->path);
+	remove(tempPath);
+	
+	struct profileStore bigger;
+	memset(&bigger, 0, sizeof(bigger));
+	if (!profileMap(&bigger, tempPath, store->header->capacity * 2))
+		return 0;
+	
+	int *buckets = profileBuckets(&bigger);
+	for (int i = 0; i < store->header->nextUnused; i++){
+		struct profileSlot *from = profileSlotAt(store, i);
+		if (!from->inUse)
+			continue;
+		int slot = bigger.header->nextUnused++;
+		struct profileSlot *to = profileSlotAt(&bigger, slot);
+		*to = *from;
+		long bucket = profileHash(to->player.name) % bigger.header->capacity;
+		to->next = buckets[bucket];
+		buckets[bucket] = slot;
+		to->crc = profileChecksum(to);
+		bigger.header->used++;
+	}
+	
+	msync(bigger.map, bigger.mapSize, MS_SYNC);
+	if (rename(tempPath, store->path) != 0){
+		profileUnmap(&bigger);
+		remove(tempPath);
+		return 0;
+	}
+	flock(bigger.fd, LOCK_EX); //other processes still on the old file see it's been replaced once they get its lock
+	profileUnlock(store);
+	profileUnmap(store);
+	snprintf(bigger.path, sizeof(bigger.path), "%s", store->path);
+	*store = bigger;
+	return 1;
+}
+
+//saves g under its player's name, replacing that profile if there is one
+int profileSave(struct profileStore *store, const struct game *g){
+	if (!profileLock(store, 1))
+		return 0;
+	
+	struct profileHeader *header = store->header;
+	int slot = profileFindSlot(store, g->player.name);
+	if (slot < 0){
+		if (header->freeHead < 0 && header->nextUnused == header->capacity){
+			if (!profileGrow(store)){
+				profileUnlock(store);
+				return 0;
+			}
+			header = store->header;
+		}
+		if (header->freeHead >= 0){ //reusing a deleted profile's slot
+			slot = header->freeHead;
+			header->freeHead = profileSlotAt(store, slot)->next;
+		} else{
+			slot = header->nextUnused++;
+		}
+		int *bucket = &profileBuckets(store)[profileHash(g->player.name) % header->capacity];
+		profileSlotAt(store, slot)->next = *bucket;
+		*bucket = slot;
+		header->used++;
+	}
+	
+	struct profileSlot *s = profileSlotAt(store, slot);
+	int next = s->next;
+	memset(s, 0, sizeof(*s));
+	s->next = next;
+	s->inUse = 1;
+	s->player = g->player;
+	s->vars = g->vars;
+	s->shoe = g->shoe;
+	memcpy(s->playerCards, g->playerHand.cards, sizeof(s->playerCards));
+	memcpy(s->dealerCards, g->dealerHand.cards, sizeof(s->dealerCards));
+	s->crc = profileChecksum(s);
+	
+	profileUnlock(store);
+	return 1;
+}
+
+//loads the profile called name into g, 0 if there isn't one, -1 if its slot is damaged
+int profileLoad(struct profileStore *store, const char *name, struct game *g){
+	if (!profileLock(store, 0))
+		return 0;
+	
+	int slot = profileFindSlot(store, name);
+	int result = 0;
+	if (slot >= 0){
+		struct profileSlot *s = profileSlotAt(store, slot);
+		result = -1;
+		if (s->crc == profileChecksum(s)){
+			g->player = s->player;
+			g->vars = s->vars;
+			g->shoe = s->shoe;
+			handEmpty(&g->playerHand);
+			handEmpty(&g->dealerHand);
+			memcpy(g->playerHand.cards, s->playerCards, sizeof(s->playerCards));
+			memcpy(g->dealerHand.cards, s->dealerCards, sizeof(s->dealerCards));
+			handRecount(&g->playerHand);
+			handRecount(&g->dealerHand);
+			result = 1;
+		}
+	}
+	
+	profileUnlock(store);
+	return result;
+}
+
+//deletes the profile called name, its slot goes on the free list for the next new profile
+int profileRemove(struct profileStore *store, const char *name){
+	if (!profileLock(store, 1))
+		return 0;
+	
+	int *link = &profileBuckets(store)[profileHash(name) % store->header->capacity];
+	int removed = 0;
+	while (*link >= 0){
+		struct profileSlot *s = profileSlotAt(store, *link);
+		if (strncmp(s->player.name, name, PROFILE_NAME) == 0){
+			int slot = *link;
+			*link = s->next;
+			s->inUse = 0;
+			s->next = store->header->freeHead;
+			store->header->freeHead = slot;
+			store->header->used--;
+			removed = 1;
+			break;
+		}
+		link = &s->next;
+	}
+	
+	profileUnlock(store);
+	return removed;
+}
+
+//up to max profile names, in slot order, returns how many there are altogether
+long profileList(struct profileStore *store, char names[][PROFILE_NAME], int max, int *listed){
+	*listed = 0;
+	if (!profileLock(store, 0))
+		return 0;
+	for (int i = 0; i < store->header->nextUnused && *listed < max; i++){
+		struct profileSlot *s = profileSlotAt(store, i);
+		if (s->inUse){
+			memcpy(names[(*listed)++], s->player.name, PROFILE_NAME);
+		}
+	}
+	long used = store->header->used;
+	profileUnlock(store);
+	return used;
+}
+
+//N profiles saved into a scratch store, then N lookups and N/2 deletes and re-saves (through the free list)
+int benchProfiles(long profiles){
+	const char *path = "bench-profiles.db";
+	remove(path);
+	struct profileStore store;
+	if (!profileStoreOpen(&store, path)){
+		printf("ERROR: couldn't create \"%s\"\n", path);
+		return(1);
+	}
+	
+	struct game g;
+	memset(&g, 0, sizeof(g));
+	g.decks = SHOE_DECKS;
+	g.penetration = SHOE_PENETRATION;
+	gameNew(&g);
+	double start = wallSeconds();
+	for (long i = 0; i < profiles; i++){
+		snprintf(g.player.name, sizeof(g.player.name), "P%d", (int)i);
+		g.vars.handNumber = i;
+		if (!profileSave(&store, &g)){
+			printf("ERROR: save %ld failed\n", i);
+			return(1);
+		}
+	}
+	double saving = wallSeconds() - start;
+	
+	long wrong = 0;
+	struct rng rng;
+	rngSeed(&rng, 1, 0);
+	start = wallSeconds();
+	for (long i = 0; i < profiles; i++){
+		long p = rngNext(&rng) % profiles;
+		char name[PROFILE_NAME];
+		snprintf(name, sizeof(name), "P%d", (int)p);
+		wrong += profileLoad(&store, name, &g) != 1 || g.vars.handNumber != p;
+	}
+	double loading = wallSeconds() - start;
+	
+	long capacity = store.header->capacity;
+	start = wallSeconds();
+	for (long i = 0; i < profiles; i += 2){
+		char name[PROFILE_NAME];
+		snprintf(name, sizeof(name), "P%d", (int)i);
+		wrong += !profileRemove(&store, name);
+	}
+	for (long i = 0; i < profiles; i += 2){
+		snprintf(g.player.name, sizeof(g.player.name), "Q%d", (int)i);
+		profileSave(&store, &g);
+	}
+	double churn = wallSeconds() - start;
+	
+	printf("%ld profiles, %lu bytes a slot, store is %.1f MB\n", profiles, (unsigned long)sizeof(struct profileSlot), store.mapSize / 1e6);
+	printf("save:            %8.3f us/profile (growing as it goes)\n", saving * 1e6 / profiles);
+	printf("load by name:    %8.3f us/profile\n", loading * 1e6 / profiles);
+	printf("delete + resave: %8.3f us/profile, capacity %ld -> %ld (free slots reused)\n", churn * 1e6 / profiles,
+		capacity, store.header->capacity);
+	printf("%s\n", wrong == 0 ? "all lookups correct" : "LOOKUP ERRORS");
+	
+	profileStoreClose(&store);
+	remove(path);
+	return(wrong == 0 ? 0 : 1);
+}
+
+//read syscalls made by this process so far (linux only), -1 if they can't be counted
+static long readSyscalls(){
+	FILE *fIn = fopen("/proc/self/io", "r");
+	char line[100];
+	long count = -1;
+	if (fIn == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), fIn)){
+		if (strncmp(line, "syscr:", 6) == 0)
+			count = atol(line + 6);
+	}
+	fclose(fIn);
+	return count;
+}
+
+//a ranks above b: higher score first, then by name so every player has one place
+static int rankBefore(const struct player *a, const struct player *b){
+	if (a->score != b->score)
+		return a->score > b->score;
+	return strncmp(a->name, b->name, PROFILE_NAME) < 0;
+}
+
+static struct rankNode *rankNodeNew(int level, struct player player){
+	struct rankNode *node = calloc(1, sizeof(struct rankNode) + level * sizeof(struct rankLink));
+	if (node != NULL){
+		node->player = player;
+		node->level = level;
+	}
+	return node;
+}
+
+//level for a new node: each level up is a quarter as likely
+static int rankRandomLevel(struct rng *rng){
+	unsigned long long bits = rngNext(rng);
+	int level = 1;
+	while (level < RANK_MAX_LEVEL && (bits & 3) == 0){
+		level++;
+		bits >>= 2;
+	}
+	return level;
+}
+
+void rankInit(struct rankBoard *board){
+	memset(board, 0, sizeof(*board));
+	struct player nobody;
+	memset(&nobody, 0, sizeof(nobody));
+	board->head = rankNodeNew(RANK_MAX_LEVEL, nobody);
+	board->level = 1;
+	board->logFd = -1;
+	rngSeed(&board->rng, 0x5EED, 0);
+}
+
+void rankFree(struct rankBoard *board){
+	struct rankNode *node = board->head;
+	while (node != NULL){
+		struct rankNode *next = node->links[0].next;
+		free(node);
+		node = next;
+	}
+	free(board->buckets);
+	if (board->logFd >= 0)
+		close(board->logFd);
+	memset(board, 0, sizeof(*board));
+	board->logFd = -1;
+}
+
+//name -> node index, doubled whenever there are more players than buckets
+static struct rankNode **rankBucket(const struct rankBoard *board, const char *name){
+	return &board->buckets[profileHash(name) & (board->bucketCount - 1)];
+}
+
+static struct rankNode *rankFind(const struct rankBoard *board, const char *name){
+	if (board->bucketCount == 0)
+		return NULL;
+	struct rankNode *node = *rankBucket(board, name);
+	while (node != NULL && strncmp(node->player.name, name, PROFILE_NAME) != 0){
+		node = node->hashNext;
+	}
+	return node;
+}
+
+static int rankIndex(struct rankBoard *board, struct rankNode *node){
+	if (board->count + 1 > board->bucketCount){
+		long bucketCount = board->bucketCount ? board->bucketCount * 2 : 1024;
+		struct rankNode **buckets = calloc(bucketCount, sizeof(struct rankNode *));
+		if (buckets == NULL)
+			return 0;
+		for (long i = 0; i < board->bucketCount; i++){
+			struct rankNode *n = board->buckets[i];
+			while (n != NULL){
+				struct rankNode *next = n->hashNext;
+				long b = profileHash(n->player.name) & (bucketCount - 1);
+				n->hashNext = buckets[b];
+				buckets[b] = n;
+				n = next;
+			}
+		}
+		free(board->buckets);
+		board->buckets = buckets;
+		board->bucketCount = bucketCount;
+	}
+	struct rankNode **bucket = rankBucket(board, node->player.name);
+	node->hashNext = *bucket;
+	*bucket = node;
+	return 1;
+}
+
+static void rankUnindex(struct rankBoard *board, struct rankNode *node){
+	struct rankNode **link = rankBucket(board, node->player.name);
+	while (*link != node){
+		link = &(*link)->hashNext;
+	}
+	*link = node->hashNext;
+}
+
+//skip list insert, every link keeps its span (how many places it jumps) so ranks can be summed on the way down
+static struct rankNode *rankInsert(struct rankBoard *board, struct player player){
+	struct rankNode *update[RANK_MAX_LEVEL];
+	long rank[RANK_MAX_LEVEL];
+	struct rankNode *x = board->head;
+	
+	for (int i = board->level - 1; i >= 0; i--){
+		rank[i] = i == board->level - 1 ? 0 : rank[i + 1];
+		while (x->links[i].next != NULL && rankBefore(&x->links[i].next->player, &player)){
+			rank[i] += x->links[i].span;
+			x = x->links[i].next;
+		}
+		update[i] = x;
+	}
+	
+	int level = rankRandomLevel(&board->rng);
+	if (level > board->level){
+		for (int i = board->level; i < level; i++){
+			rank[i] = 0;
+			update[i] = board->head;
+			update[i]->links[i].span = board->count;
+		}
+		board->level = level;
+	}
+	
+	struct rankNode *node = rankNodeNew(level, player);
+	if (node == NULL)
+		return NULL;
+	for (int i = 0; i < level; i++){
+		node->links[i].next = update[i]->links[i].next;
+		update[i]->links[i].next = node;
+		node->links[i].span = update[i]->links[i].span - (rank[0] - rank[i]);
+		update[i]->links[i].span = rank[0] - rank[i] + 1;
+	}
+	for (int i = level; i < board->level; i++){
+		update[i]->links[i].span++;
+	}
+	board->count++;
+	return node;
+}
+
+static void rankDelete(struct rankBoard *board, struct rankNode *node){
+	struct rankNode *update[RANK_MAX_LEVEL];
+	struct rankNode *x = board->head;
+	
+	for (int i = board->level - 1; i >= 0; i--){
+		while (x->links[i].next != NULL && x->links[i].next != node && rankBefore(&x->links[i].next->player, &node->player)){
+			x = x->links[i].next;
+		}
+		update[i] = x;
+	}
+	for (int i = 0; i < board->level; i++){
+		if (update[i]->links[i].next == node){
+			update[i]->links[i].span += node->links[i].span - 1;
+			update[i]->links[i].next = node->links[i].next;
+		} else{
+			update[i]->links[i].span--;
+		}
+	}
+	while (board->level > 1 && board->head->links[board->level - 1].next == NULL){
+		board->level--;
+	}
+	board->count--;
+	free(node);
+}
+
+//O(log n): puts the player on the board, or moves them up if this beats their best, returns 1 if anything changed
+int rankSubmit(struct rankBoard *board, struct player player){
+	struct player clean; //name zero padded, so hashing and comparing never see what's after the terminator
+	memset(&clean, 0, sizeof(clean));
+	memcpy(clean.name, player.name, strnlen(player.name, PROFILE_NAME - 1));
+	clean.score = player.score;
+	
+	struct rankNode *old = rankFind(board, clean.name);
+	if (old != NULL){
+		if (old->player.score >= clean.score)
+			return 0;
+		rankUnindex(board, old);
+		rankDelete(board, old);
+	}
+	struct rankNode *node = rankInsert(board, clean);
+	if (node == NULL)
+		return 0;
+	if (!rankIndex(board, node)){
+		rankDelete(board, node);
+		return 0;
+	}
+	return 1;
+}
+
+//O(log n): 1 for the top player, 0 if name isn't on the board
+long rankOf(const struct rankBoard *board, const char *name){
+	struct rankNode *node = rankFind(board, name);
+	if (node == NULL)
+		return 0;
+	
+	struct rankNode *x = board->head;
+	long rank = 0;
+	for (int i = board->level - 1; i >= 0; i--){
+		while (x->links[i].next != NULL && !rankBefore(&node->player, &x->links[i].next->player)){
+			rank += x->links[i].span;
+			x = x->links[i].next;
+		}
+		if (x == node)
+			return rank;
+	}
+	return 0;
+}
+
+//O(log n + k): the k players from place first on (1 is the top), returns how many there were
+int rankRange(const struct rankBoard *board, long first, struct player *out, int k){
+	struct rankNode *x = board->head;
+	long rank = 0;
+	for (int i = board->level - 1; i >= 0; i--){
+		while (x->links[i].next != NULL && rank + x->links[i].span < first){
+			rank += x->links[i].span;
+			x = x->links[i].next;
+		}
+	}
+	
+	int n = 0;
+	for (x = x->links[0].next; x != NULL && n < k; x = x->links[0].next){
+		out[n++] = x->player;
+	}
+	return n;
+}
+
+//rewrites leaderboard.db with count players in rank order (temp file + rename), then empties the log
+//players NULL walks the board itself, rankSharedLog passes a copy so the board can change while it's written
+static int rankWrite(struct rankBoard *board, const struct player *players, long count){
+	char tempPath[JOURNAL_PATH_MAX + 4];
+	snprintf(tempPath, sizeof(tempPath), "%s.tmp", board->path);
+	FILE *fOut = fopen(tempPath, "wb");
+	if (fOut == NULL)
+		return 0;
+	
+	struct rankFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RANK_MAGIC, sizeof(header.magic));
+	header.version = RANK_VERSION;
+	header.entrySize = sizeof(struct player);
+	header.count = count;
+	int ok = fwrite(&header, sizeof(header), 1, fOut) == 1;
+	if (players != NULL){
+		ok = ok && fwrite(players, sizeof(struct player), count, fOut) == (size_t)count;
+	} else{
+		for (struct rankNode *x = board->head->links[0].next; x != NULL && ok; x = x->links[0].next){
+			ok = fwrite(&x->player, sizeof(x->player), 1, fOut) == 1;
+		}
+	}
+	ok &= fflush(fOut) == 0 && fsync(fileno(fOut)) == 0;
+	ok &= fclose(fOut) == 0;
+	if (!ok || rename(tempPath, board->path) != 0){
+		remove(tempPath);
+		return 0;
+	}
+	
+	//a crash before this just replays submissions that are already in, which changes nothing
+	char logPath[JOURNAL_PATH_MAX + 4];
+	snprintf(logPath, sizeof(logPath), "%s.log", board->path);
+	if (board->logFd >= 0)
+		close(board->logFd);
+	board->logFd = open(logPath, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+	board->logged = 0;
+	return 1;
+}
+
+//rewrites leaderboard.db with every player in rank order, then empties the log
+int rankSave(struct rankBoard *board){
+	return rankWrite(board, NULL, board->count);
+}
+
+//appends a batch of submissions to leaderboard.db.log in one write (rankSharedLog decides when to rewrite instead)
+int rankLogSubmit(struct rankBoard *board, const struct player *players, long count){
+	if (board->path[0] == '\0' || board->logFd < 0) //a board only kept in memory, or the log couldn't be opened
+		return 0;
+	struct rankRecord *records = calloc(count > 0 ? count : 1, sizeof(struct rankRecord));
+	if (records == NULL)
+		return 0;
+	for (long i = 0; i < count; i++){
+		memcpy(records[i].player.name, players[i].name, strnlen(players[i].name, PROFILE_NAME - 1));
+		records[i].player.score = players[i].score;
+		records[i].crc = crc32(&records[i].player, sizeof(records[i].player));
+	}
+	size_t bytes = count * sizeof(struct rankRecord);
+	int ok = write(board->logFd, records, bytes) == (ssize_t)bytes;
+	free(records);
+	if (ok)
+		board->logged += count;
+	return ok;
+}
+
+//reads leaderboard.db (already in rank order, so the skip list is built left to right in O(n))
+//then replays leaderboard.db.log on top, returns 0 if there's no board yet
+int rankLoad(struct rankBoard *board, const char *path){
+	rankInit(board);
+	snprintf(board->path, sizeof(board->path), "%s", path);
+	int found = 0;
+	
+	FILE *fIn = fopen(path, "rb");
+	if (fIn != NULL){
+		struct rankFileHeader header;
+		if (fread(&header, sizeof(header), 1, fIn) == 1 && memcmp(header.magic, RANK_MAGIC, sizeof(header.magic)) == 0
+			&& header.version == RANK_VERSION && header.entrySize == (int)sizeof(struct player)){
+			struct rankNode *last[RANK_MAX_LEVEL];
+			long lastRank[RANK_MAX_LEVEL];
+			for (int i = 0; i < RANK_MAX_LEVEL; i++){
+				last[i] = board->head;
+				lastRank[i] = 0;
+			}
+			
+			struct player player;
+			for (long r = 1; r <= header.count && fread(&player, sizeof(player), 1, fIn) == 1; r++){
+				int level = rankRandomLevel(&board->rng);
+				struct rankNode *node = rankNodeNew(level, player);
+				if (node == NULL || !rankIndex(board, node)){
+					free(node);
+					break;
+				}
+				for (int i = 0; i < level; i++){
+					last[i]->links[i].next = node;
+					last[i]->links[i].span = r - lastRank[i];
+					last[i] = node;
+					lastRank[i] = r;
+				}
+				if (level > board->level)
+					board->level = level;
+				board->count = r;
+			}
+			for (int i = 0; i < board->level; i++){
+				last[i]->links[i].span = board->count - lastRank[i];
+			}
+			found = 1;
+		}
+		fclose(fIn);
+	}
+	
+	char logPath[JOURNAL_PATH_MAX + 4];
+	snprintf(logPath, sizeof(logPath), "%s.log", path);
+	fIn = fopen(logPath, "rb");
+	if (fIn != NULL){
+		struct rankRecord record;
+		while (fread(&record, sizeof(record), 1, fIn) == 1 && record.crc == crc32(&record.player, sizeof(record.player))){
+			rankSubmit(board, record.player);
+			board->logged++;
+			found = 1;
+		}
+		fclose(fIn);
+	}
+	board->logFd = open(logPath, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	return found;
+}
+
+//publishes the top of the board for readers, caller holds boardLock
+//seqlock: odd while it's being written, readers copy and retry if it changed under them
+static void rankSharedPublish(struct rankShared *shared){
+	atomic_fetch_add_explicit(&shared->snapshotSeq, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	shared->snapshot.count = shared->board.count;
+	shared->snapshot.filled = rankRange(&shared->board, 1, shared->snapshot.top, RANK_SNAPSHOT_TOP);
+	atomic_fetch_add_explicit(&shared->snapshotSeq, 1, memory_order_release);
+}
+
+//caller holds boardLock: keeps a submission that changed the board for rankSharedLog to write out
+static void rankSharedKeep(struct rankShared *shared, struct player player){
+	if (shared->unloggedCount == shared->unloggedCapacity){
+		long capacity = shared->unloggedCapacity > 0 ? shared->unloggedCapacity * 2 : RANK_SHARD_PENDING;
+		struct player *grown = realloc(shared->unlogged, capacity * sizeof(struct player));
+		if (grown == NULL){
+			shared->rewrite = 1; //it's on the board, so rewriting leaderboard.db still keeps it
+			return;
+		}
+		shared->unlogged = grown;
+		shared->unloggedCapacity = capacity;
+	}
+	shared->unlogged[shared->unloggedCount++] = player;
+}
+
+//writes what the merges left in unlogged to leaderboard.db.log, or rewrites leaderboard.db once the log is as long as the board
+//boardLock is only held to swap the batch out (and copy the ranking for a rewrite), the files are written under logLock alone
+static void rankSharedLog(struct rankShared *shared){
+	if (shared->board.path[0] == '\0') //a board only kept in memory
+		return;
+	pthread_mutex_lock(&shared->logLock);
+	pthread_mutex_lock(&shared->boardLock);
+	struct player *batch = shared->unlogged;
+	long count = shared->unloggedCount;
+	long capacity = shared->unloggedCapacity;
+	shared->unlogged = shared->logging;
+	shared->unloggedCapacity = shared->loggingCapacity;
+	shared->unloggedCount = 0;
+	shared->logging = batch;
+	shared->loggingCapacity = capacity;
+	
+	//a rewrite costs a record per player, so the log is let grow as long as the board
+	long players = shared->board.count;
+	struct player *ranking = NULL;
+	if (shared->board.logFd < 0 || shared->rewrite
+			|| shared->board.logged + count > (players > RANK_LOG_COMPACT ? players : RANK_LOG_COMPACT)){
+		ranking = malloc((players > 0 ? players : 1) * sizeof(struct player));
+		if (ranking != NULL){
+			rankRange(&shared->board, 1, ranking, players);
+			shared->rewrite = 0;
+		}
+	}
+	pthread_mutex_unlock(&shared->boardLock);
+	
+	if (ranking != NULL){
+		if (!rankWrite(&shared->board, ranking, players))
+			rankLogSubmit(&shared->board, batch, count); //leaderboard.db is as it was, so keep the batch in the log
+		free(ranking);
+	} else if (count > 0){
+		rankLogSubmit(&shared->board, batch, count);
+	}
+	pthread_mutex_unlock(&shared->logLock);
+}
+
+//moves every shard's pending submissions onto the board and publishes a new snapshot, no disk I/O
+static void rankSharedApply(struct rankShared *shared){
+	pthread_mutex_lock(&shared->boardLock);
+	long merged = 0;
+	for (int s = 0; s < RANK_SHARDS; s++){
+		struct rankShard *shard = &shared->shards[s];
+		pthread_mutex_lock(&shard->lock); //held just long enough to copy the buffer out
+		int count = shard->count;
+		memcpy(shared->draining, shard->pending, count * sizeof(struct player));
+		shard->count = 0;
+		pthread_mutex_unlock(&shard->lock);
+		
+		for (int i = 0; i < count; i++){
+			if (rankSubmit(&shared->board, shared->draining[i]) && shared->board.path[0] != '\0')
+				rankSharedKeep(shared, shared->draining[i]);
+		}
+		merged += count;
+	}
+	shared->merged += merged;
+	shared->merges++;
+	rankSharedPublish(shared);
+	pthread_mutex_unlock(&shared->boardLock);
+}
+
+//merges the shards onto the board, with a merge thread the log is left for it to write
+//so a session's thread (a full shard, a game over merged right away) never waits on the disk
+void rankSharedMerge(struct rankShared *shared){
+	rankSharedApply(shared);
+	if (!shared->merging)
+		rankSharedLog(shared);
+}
+
+static void *rankSharedRun(void *arg){
+	struct rankShared *shared = arg;
+	pthread_mutex_lock(&shared->timerLock);
+	while (!shared->stop){
+		struct timespec until;
+		clock_gettime(CLOCK_REALTIME, &until);
+		until.tv_nsec += shared->mergeMs * 1000000L;
+		until.tv_sec += until.tv_nsec / 1000000000L;
+		until.tv_nsec %= 1000000000L;
+		pthread_cond_timedwait(&shared->timer, &shared->timerLock, &until);
+		pthread_mutex_unlock(&shared->timerLock);
+		rankSharedApply(shared);
+		rankSharedLog(shared);
+		pthread_mutex_lock(&shared->timerLock);
+	}
+	pthread_mutex_unlock(&shared->timerLock);
+	return NULL;
+}
+
+//path NULL for a board only kept in memory, mergeMs 0 merges only when asked (rankSharedMerge)
+int rankSharedOpen(struct rankShared *shared, const char *path, int mergeMs){
+	int found = 0;
+	if (path != NULL){
+		found = rankLoad(&shared->board, path);
+	} else{
+		rankInit(&shared->board);
+	}
+	pthread_mutex_init(&shared->boardLock, NULL);
+	pthread_mutex_init(&shared->logLock, NULL);
+	shared->unlogged = shared->logging = NULL;
+	shared->unloggedCount = shared->unloggedCapacity = shared->loggingCapacity = 0;
+	shared->rewrite = 0;
+	for (int s = 0; s < RANK_SHARDS; s++){
+		pthread_mutex_init(&shared->shards[s].lock, NULL);
+		shared->shards[s].count = 0;
+	}
+	atomic_init(&shared->snapshotSeq, 0);
+	shared->merged = shared->merges = 0;
+	rankSharedPublish(shared);
+	
+	shared->mergeMs = mergeMs;
+	shared->stop = 0;
+	pthread_mutex_init(&shared->timerLock, NULL);
+	pthread_cond_init(&shared->timer, NULL);
+	shared->merging = mergeMs > 0 && pthread_create(&shared->merger, NULL, rankSharedRun, shared) == 0;
+	return found;
+}
+
+//stops the merge thread, merges and writes what's left
+void rankSharedClose(struct rankShared *shared){
+	if (shared->merging){
+		pthread_mutex_lock(&shared->timerLock);
+		shared->stop = 1;
+		pthread_cond_signal(&shared->timer);
+		pthread_mutex_unlock(&shared->timerLock);
+		pthread_join(shared->merger, NULL);
+		shared->merging = 0;
+	}
+	rankSharedMerge(shared);
+	rankFree(&shared->board);
+	free(shared->unlogged);
+	free(shared->logging);
+	for (int s = 0; s < RANK_SHARDS; s++){
+		pthread_mutex_destroy(&shared->shards[s].lock);
+	}
+	pthread_mutex_destroy(&shared->boardLock);
+	pthread_mutex_destroy(&shared->logLock);
+	pthread_mutex_destroy(&shared->timerLock);
+	pthread_cond_destroy(&shared->timer);
+}
+
+//any thread: queues a score in the shard its name hashes to, only merging itself if that shard is full
+void rankSharedSubmit(struct rankShared *shared, struct player player){
+	struct rankShard *shard = &shared->shards[profileHash(player.name) % RANK_SHARDS];
+	pthread_mutex_lock(&shard->lock);
+	while (shard->count == RANK_SHARD_PENDING){
+		pthread_mutex_unlock(&shard->lock);
+		rankSharedMerge(shared);
+		pthread_mutex_lock(&shard->lock);
+	}
+	shard->pending[shard->count++] = player;
+	pthread_mutex_unlock(&shard->lock);
+}
+
+//any thread, never blocks: the top k as of the last merge, returns how many there were
+int rankSharedTop(struct rankShared *shared, struct player *out, int k, long *count){
+	if (k > RANK_SNAPSHOT_TOP)
+		k = RANK_SNAPSHOT_TOP;
+	unsigned int before, after;
+	int filled;
+	do{
+		before = atomic_load_explicit(&shared->snapshotSeq, memory_order_acquire);
+		filled = shared->snapshot.filled < k ? shared->snapshot.filled : k;
+		memcpy(out, shared->snapshot.top, filled * sizeof(struct player));
+		if (count != NULL)
+			*count = shared->snapshot.count;
+		atomic_thread_fence(memory_order_acquire);
+		after = atomic_load_explicit(&shared->snapshotSeq, memory_order_relaxed);
+	} while ((before & 1) || before != after);
+	return filled;
+}
+
+//rank as of the last merge, 0 if not ranked yet
+long rankSharedRankOf(struct rankShared *shared, const char *name){
+	pthread_mutex_lock(&shared->boardLock);
+	long rank = rankOf(&shared->board, name);
+	pthread_mutex_unlock(&shared->boardLock);
+	return rank;
+}
+
+struct rankBenchWorker{
+	struct rankShared *shared;
+	pthread_mutex_t *oneLock; //set for the single lock comparison: rankSubmit straight onto the board under it
+	long submissions;
+	long players;
+	int id;
+	atomic_int *running; //writers still going, the reader stops when it hits 0
+	long reads;
+};
+
+static void *rankBenchWrite(void *arg){
+	struct rankBenchWorker *w = arg;
+	struct rng rng;
+	rngSeed(&rng, 7, w->id);
+	struct player p;
+	memset(&p, 0, sizeof(p));
+	for (long i = 0; i < w->submissions; i++){
+		snprintf(p.name, sizeof(p.name), "P%d", (int)(rngNext(&rng) % w->players));
+		p.score = rngNext(&rng) % 1000000;
+		if (w->oneLock != NULL){
+			pthread_mutex_lock(w->oneLock);
+			rankSubmit(&w->shared->board, p);
+			pthread_mutex_unlock(w->oneLock);
+		} else{
+			rankSharedSubmit(w->shared, p);
+		}
+	}
+	atomic_fetch_sub(w->running, 1);
+	return NULL;
+}
+
+static void *rankBenchRead(void *arg){ //a title screen refreshing the top 10 as fast as it can
+	struct rankBenchWorker *w = arg;
+	struct player top[10];
+	long count;
+	while (atomic_load(w->running) > 0){
+		if (w->oneLock != NULL){
+			pthread_mutex_lock(w->oneLock);
+			rankRange(&w->shared->board, 1, top, 10);
+			pthread_mutex_unlock(w->oneLock);
+		} else{
+			rankSharedTop(w->shared, top, 10, &count);
+		}
+		w->reads++;
+	}
+	return NULL;
+}
+
+//submissions a second from 1, 2, 4 .. threads writers, sharded vs every writer taking one lock,
+//with one more thread reading the top 10 the whole time (under the lock, or from the snapshot)
+static int benchLeaderboardThreads(long submissions, long players, int threads){
+	printf("\n%ld submissions over %ld names, merged every %d ms, plus one top 10 reader\n", submissions, players, RANK_MERGE_MS);
+	printf("%-8s %14s %14s %14s %14s %8s\n", "threads", "one lock/s", "reads/s", "sharded/s", "reads/s", "merges");
+	int wrong = 0;
+	for (int t = 1; t <= threads; t = t < threads && t * 2 > threads ? threads : t * 2){
+		double rate[2];
+		long reads[2], merges = 0, counts[2];
+		struct player tops[2][10];
+		for (int mode = 0; mode < 2; mode++){
+			static struct rankShared shared; //too big for a thread's stack
+			pthread_mutex_t oneLock;
+			pthread_mutex_init(&oneLock, NULL);
+			rankSharedOpen(&shared, NULL, mode == 1 ? RANK_MERGE_MS : 0);
+			atomic_int running;
+			atomic_init(&running, t);
+			
+			struct rankBenchWorker workers[t + 1];
+			pthread_t ids[t + 1];
+			for (int i = 0; i <= t; i++){
+				workers[i] = (struct rankBenchWorker){&shared, mode == 0 ? &oneLock : NULL, submissions / t, players, i, &running, 0};
+			}
+			double start = wallSeconds();
+			for (int i = 0; i < t; i++){
+				pthread_create(&ids[i], NULL, rankBenchWrite, &workers[i]);
+			}
+			pthread_create(&ids[t], NULL, rankBenchRead, &workers[t]);
+			for (int i = 0; i < t; i++){
+				pthread_join(ids[i], NULL);
+			}
+			double seconds = wallSeconds() - start;
+			pthread_join(ids[t], NULL);
+			rate[mode] = (submissions / t) * t / seconds;
+			reads[mode] = workers[t].reads / seconds;
+			
+			//every submission made it onto the board: the same names and best scores as with one lock
+			rankSharedMerge(&shared);
+			counts[mode] = shared.board.count;
+			rankSharedTop(&shared, tops[mode], 10, NULL);
+			if (mode == 1){
+				merges = shared.merges;
+				wrong += shared.merged != (submissions / t) * t || counts[0] != counts[1] || memcmp(tops[0], tops[1], sizeof(tops[0])) != 0;
+			}
+			rankSharedClose(&shared);
+			pthread_mutex_destroy(&oneLock);
+		}
+		printf("%-8d %14.0f %14ld %14.0f %14ld %8ld\n", t, rate[0], reads[0], rate[1], reads[1], merges);
+	}
+	return wrong;
+}
+
+//N random players submitted, then N rank lookups checked against a walk of the list, a top 10, a save and a reload
+int benchLeaderboard(long players, int threads){
+	const char *path = "bench-leaderboard.db";
+	struct rankBoard board;
+	remove(path);
+	rankInit(&board);
+	snprintf(board.path, sizeof(board.path), "%s", path);
+	
+	struct rng rng;
+	rngSeed(&rng, 7, 0);
+	struct player p;
+	memset(&p, 0, sizeof(p));
+	double start = wallSeconds();
+	for (long i = 0; i < players; i++){
+		snprintf(p.name, sizeof(p.name), "P%d", (int)i);
+		p.score = rngNext(&rng) % 100000;
+		rankSubmit(&board, p);
+	}
+	for (long i = 0; i < players; i++){ //every player improves once, a remove and reinsert each
+		snprintf(p.name, sizeof(p.name), "P%d", (int)(rngNext(&rng) % players));
+		p.score = 100000 + rngNext(&rng) % 100000;
+		rankSubmit(&board, p);
+	}
+	double submitting = wallSeconds() - start;
+	
+	start = wallSeconds();
+	long sum = 0;
+	for (long i = 0; i < players; i++){
+		char name[PROFILE_NAME];
+		snprintf(name, sizeof(name), "P%d", (int)(rngNext(&rng) % players));
+		sum += rankOf(&board, name);
+	}
+	double ranking = wallSeconds() - start;
+	
+	long wrong = 0, r = 0; //every rank checked against its position in the list
+	for (struct rankNode *x = board.head->links[0].next; x != NULL; x = x->links[0].next){
+		r++;
+		if (r % 97 == 1)
+			wrong += rankOf(&board, x->player.name) != r;
+	}
+	struct player top[10];
+	start = wallSeconds();
+	int n = rankRange(&board, board.count / 2, top, 10);
+	double range = wallSeconds() - start;
+	wrong += n != 10 || rankOf(&board, top[0].name) != board.count / 2;
+	
+	start = wallSeconds();
+	int saved = rankSave(&board);
+	double saving = wallSeconds() - start;
+	long count = board.count;
+	rankFree(&board);
+	start = wallSeconds();
+	rankLoad(&board, path);
+	double loading = wallSeconds() - start;
+	wrong += !saved || board.count != count || rankOf(&board, top[0].name) != count / 2;
+	
+	printf("%ld players, %ld submissions (sum of ranks %ld)\n", count, 2 * players, sum);
+	printf("submit:        %8.3f us\n", submitting * 1e6 / (2 * players));
+	printf("rank of:       %8.3f us\n", ranking * 1e6 / players);
+	printf("10 from middle:%8.3f us\n", range * 1e6);
+	printf("save %.1f MB:  %8.3f ms, load %.3f ms\n", (sizeof(struct rankFileHeader) + count * sizeof(struct player)) / 1e6,
+		saving * 1e3, loading * 1e3);
+	
+	rankFree(&board);
+	wrong += benchLeaderboardThreads(4 * players, players, threads);
+	printf("%s\n", wrong == 0 ? "ranks correct" : "RANK ERRORS");
+	remove(path);
+	char logPath[JOURNAL_PATH_MAX + 4];
+	snprintf(logPath, sizeof(logPath), "%s.log", path);
+	remove(logPath);
+	return(wrong == 0 ? 0 : 1);
+}
+
+//what getting from the title menu to a loaded leaderboard costs three ways: the old text save reopened and
+//parsed every pass, the binary save reread every pass, and the cache (a stat, no read unless it changed)
+//works on scratch files so the real save is left alone
+int benchMenu(long passes){
+	const char *textPath = "bench-save.txt";
+	const char *binaryPath = "bench-save.bin";
+	struct player leaderboard[10];
+	static struct rankShared board;
+	rankSharedOpen(&board, NULL, 0);
+	struct saveCache cache;
+	memset(&cache, 0, sizeof(cache));
+	cache.journal.fd = -1;
+	resetLeaderboard(cache.save.leaderboard);
+	
+	FILE *fOut = fopen(textPath, "w"); //a text save as the old saveGame wrote it, 153 lines
+	if (fOut == NULL || !writeSave(&cache.save, binaryPath)){
+		printf("ERROR: couldn't write the scratch saves\n");
+		return(1);
+	}
+	for (int i = 0; i < 10; i++){
+		fprintf(fOut, "%s\n%ld\n", "PLAYER", 100L * i);
+	}
+	fprintf(fOut, "PLAYER\n0\n");
+	for (int i = 0; i < 52; i++){
+		fprintf(fOut, "%d\n%d\n", i / 13 + 1, i % 13 + 1);
+	}
+	for (int i = 0; i < 10; i++){
+		fprintf(fOut, "0\n0\n");
+	}
+	fprintf(fOut, "100\n1\n0\n0\n0\n-1\n0\n");
+	fclose(fOut);
+	
+	printf("%ld menu passes each\n", passes);
+	printf("%-16s %12s %10s %10s %10s\n", "", "us/pass", "opens", "reads", "stats");
+	for (int mode = 0; mode < 3; mode++){
+		long opens = 0, stats = 0, reads = readSyscalls();
+		double start = wallSeconds();
+		for (long p = 0; p < passes; p++){
+			if (mode == 0){ //the old loop: an existence check, then a separate open to scan and parse
+				struct saveFile save;
+				FILE *fIn = fopen(textPath, "r");
+				fclose(fIn);
+				fIn = fopen(textPath, "r");
+				loadTextSave(fIn, &save);
+				fclose(fIn);
+				loadLeaderboard(&board, &save, leaderboard);
+				opens += 2;
+			} else if (mode == 1){
+				struct saveFile save;
+				readSave(&save, binaryPath);
+				if (validFile(&save))
+					loadLeaderboard(&board, &save, leaderboard);
+				opens++;
+			} else{
+				saveCacheRefresh(&cache, binaryPath);
+				if (cache.valid)
+					loadLeaderboard(&board, &cache.save, leaderboard);
+			}
+		}
+		double seconds = wallSeconds() - start;
+		if (mode == 2){
+			opens = cache.reads;
+			stats = cache.stats;
+		}
+		if (reads != -1)
+			reads = readSyscalls() - reads - 1; //less the read of /proc/self/io itself
+		
+		const char *names[3] = {"text, reopened", "binary, reread", "binary, cached"};
+		printf("%-16s %12.3f %10.3f ", names[mode], seconds * 1e6 / passes, (double)opens / passes);
+		if (reads >= 0){
+			printf("%10.3f ", (double)reads / passes);
+		} else{
+			printf("%10s ", "n/a");
+		}
+		printf("%10.3f\n", (double)stats / passes);
+	}
+	
+	rankSharedClose(&board);
+	remove(textPath);
+	remove(binaryPath);
+	return(0);
+}
+
+//one round under the dealer's rule, drawn the way the game shows a settled hand when render is set
+static void benchRenderRound(struct game *g, int render){
+	enum roundEventEnum result = EVENT_NONE;
+	int lower, upper;
+	
+	if (gameIsOver(g))
+		gameNew(g);
+	gameDealFirst(g);
+	gamePlaceBet(g, policyMimicDealer(g, DECIDE_BET, 1, 10, NULL));
+	while (g->vars.gameState != 6){
+		switch (g->vars.gameState){
+			case 1:
+				gameCheckBlackjack(g);
+				break;
+			case 2:
+				switch (policyMimicDealer(g, DECIDE_ACTION, BUY, STICK, NULL)){
+					case BUY:
+						gameBuyLimits(g, &lower, &upper);
+						gameBuy(g, policyMimicDealer(g, DECIDE_BUY, lower, upper, NULL));
+						break;
+					case TWIST:
+						gameTwist(g);
+						break;
+					default:
+						gameStick(g);
+						break;
+				}
+				break;
+			case 3:
+				gameResolvePlayer(g);
+				break;
+			case 4:
+				gameDealerTurn(g);
+				break;
+			case 5:
+				result = gameSettle(g);
+				break;
+		}
+	}
+	if (render){
+		displayTable(g, 1);
+		if (result != EVENT_NONE)
+			displaySettlement(g, result);
+	}
+}
+
+//settling a round and drawing it into the frame (never flushed) against the engine alone
+int benchRender(long rounds){
+	struct game g;
+	memset(&g, 0, sizeof(g));
+	strcpy(g.player.name, "BENCH");
+	g.decks = SHOE_DECKS;
+	g.penetration = SHOE_PENETRATION;
+	
+	printf("%ld rounds each\n", rounds);
+	printf("%-16s %12s %14s\n", "", "ns/round", "bytes/frame");
+	double seconds[2];
+	for (int mode = 0; mode < 2; mode++){
+		long bytes = 0;
+		rngSeed(&g.rng, 1, 0);
+		gameNew(&g);
+		double start = wallSeconds();
+		for (long r = 0; r < rounds; r++){
+			benchRenderRound(&g, mode);
+			bytes += screen.length;
+		}
+		seconds[mode] = wallSeconds() - start;
+		
+		const char *names[2] = {"engine", "settle+render"};
+		printf("%-16s %12.1f %14.1f\n", names[mode], seconds[mode] * 1e9 / rounds, (double)bytes / rounds);
+	}
+	printf("%-16s %12.1f\n", "render alone", (seconds[1] - seconds[0]) * 1e9 / rounds);
+	screenClear();
+	return(0);
+}
+
+//what making every hand durable costs: rewriting the whole save (temp file, fsync, rename) after each hand
+//against appending a journal record (fsync every JOURNAL_SYNC_EVERY), on scratch files
+//then the game thread's side of handing every hand's save to the background writer
+int benchJournal(long hands){
+	const char *path = "bench-journal.bin";
+	char journalPath[JOURNAL_PATH_MAX];
+	journalPathFor(journalPath, sizeof(journalPath), path);
+	struct saveCache cache;
+	memset(&cache, 0, sizeof(cache));
+	cache.journal.fd = -1;
+	resetLeaderboard(cache.save.leaderboard);
+	strcpy(cache.save.current.name, "BENCH");
+	cache.save.vars.money = 100;
+	
+	double start = wallSeconds();
+	for (long h = 0; h < hands; h++){
+		cache.save.vars.handNumber++;
+		if (!writeSave(&cache.save, path)){
+			printf("ERROR: couldn't write \"%s\"\n", path);
+			return(1);
+		}
+	}
+	double rewrite = wallSeconds() - start;
+	
+	saveCacheWrite(&cache, path);
+	start = wallSeconds();
+	for (long h = 0; h < hands; h++){
+		cache.save.vars.handNumber++;
+		if (journalAppend(&cache.journal, cache.save.current, cache.save.vars) < 0){
+			printf("ERROR: couldn't write \"%s\"\n", journalPath);
+			return(1);
+		}
+	}
+	journalClose(&cache.journal);
+	double journal = wallSeconds() - start;
+	
+	//checking the journal replays to the last hand
+	struct saveFile replayed;
+	readSave(&replayed, path);
+	long applied = journalReplay(&replayed, path);
+	
+	struct saveWriter writer;
+	if (!saveWriterStart(&writer, path)){
+		printf("ERROR: couldn't start the save writer\n");
+		return(1);
+	}
+	start = wallSeconds();
+	for (long h = 0; h < hands; h++){
+		cache.save.vars.handNumber++;
+		sealSave(&cache.save);
+		saveWriterSubmit(&writer, &cache.save);
+	}
+	double submit = wallSeconds() - start;
+	saveWriterFlush(&writer);
+	double drained = wallSeconds() - start;
+	saveWriterStop(&writer);
+	struct saveFile written;
+	readSave(&written, path);
+	
+	printf("%ld hands\n", hands);
+	printf("rewrite save every hand: %9.1f us/hand\n", rewrite * 1e6 / hands);
+	printf("journal every hand:      %9.1f us/hand (%.1fx faster)\n", journal * 1e6 / hands, journal > 0 ? rewrite / journal : 0.0);
+	printf("replay: %ld records, ends at hand %d %s\n", applied, replayed.vars.handNumber,
+		replayed.vars.handNumber == 2 * hands ? "(ok)" : "(MISMATCH)");
+	printf("background save every hand: %6.1f us/hand on the game thread, %.1f us/hand until on disk\n",
+		submit * 1e6 / hands, drained * 1e6 / hands);
+	printf("  %ld writes for %ld snapshots (%ld coalesced), last on disk is hand %d %s\n", writer.completed, writer.submitted,
+		writer.coalesced, written.vars.handNumber, written.vars.handNumber == cache.save.vars.handNumber ? "(ok)" : "(MISMATCH)");
+	
+	remove(path);
+	remove(journalPath);
+	return(replayed.vars.handNumber == 2 * hands && written.vars.handNumber == cache.save.vars.handNumber ? 0 : 1);
+}
+
+//resets initializing leaderboard before loading values
+void resetLeaderboard(struct player *leaderboard){
+	for (int i = 0; i < 10; i++){
+		strcpy(leaderboard[i].name, "");
+		leaderboard[i].score = 0;
+	}
+}
+
+//C4: ARRAY OF STRUCT FUNCTION
+long updateLeaderboard(struct rankShared *board, struct player *leaderboard, struct player currentPlayer, int mergeNow){
+	rankSharedSubmit(board, currentPlayer);
+	if (mergeNow || !board->merging) //nobody else will merge it, or not before it's read back
+		rankSharedMerge(board);
+	long ranked;
+	resetLeaderboard(leaderboard);
+	rankSharedTop(board, leaderboard, 10, &ranked);
+	return ranked;
+}
+
+//C5 function with pointer to var type int
+//draws from top of the shoe and updates the draw posotion
+void topDraw(struct hand *hand, struct shoe *shoe, int *position, struct rng *rng){
+	handAdd(hand, shoeDraw(shoe, position, rng));
+}
+
+//populates deck with one of each kind of card (not shuffled
+void deckPopulate(struct card deck[52]){
+
+	int a, b, k = 0;
+	for (a = 1; a < 5; a++){
+		for (b = 1; b < 14; b++){
+			deck[k] = cardMake(a, b);
+			k++;
+		}
+	}
+	
+}
+
+//displays deck, only for debug
+void deckDisplay(struct card deck[52]){
+	int a, b, k = 0;
+	for (a = 1; a < 5; a++){
+		for (b = 1; b < 14; b++){
+			printf("%d %d %d\n", k, cardSuitOf(deck[k]), cardKindOf(deck[k]));
+			k++;
+		}
+	}
+}
+
+void deckShuffle(struct card *deck, struct rng *rng){ //function to shuffle deck using fisher yates algorithm
+	
+	//int i set to size of deck, decreases range of swap on each loop iteration
+	for (int i = 51; i > 0; i --){
+		int j = rngBelow(rng, i + 1); //picking a random element between 0 and i
+		//swap (deck, i, j);
+		swapCard(&deck[i], &deck[j]);
+	}
+}
+
+//splitmix64 (see https://prng.di.unimi.it/splitmix64.c), only used to expand seeds into xoshiro state
+static unsigned long long splitMix(unsigned long long *state){
+	unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static unsigned long long rotateLeft(unsigned long long x, int k){
+	return (x << k) | (x >> (64 - k));
+}
+
+//xoshiro256** (see https://prng.di.unimi.it/xoshiro256starstar.c)
+unsigned long long rngNext(struct rng *rng){
+	unsigned long long *s = rng->s;
+	unsigned long long result = rotateLeft(s[1] * 5, 7) * 9;
+	unsigned long long t = s[1] << 17;
+	
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotateLeft(s[3], 45);
+	return result;
+}
+
+//the stream number is hashed into the seed, so stream k is reached directly without drawing streams 0..k-1
+void rngSeed(struct rng *rng, unsigned long long seed, unsigned long long stream){
+	unsigned long long state = stream;
+	state = seed ^ splitMix(&state);
+	for (int i = 0; i < 4; i++){
+		rng->s[i] = splitMix(&state);
+	}
+}
+
+//lemire's multiply and reject (see https://arxiv.org/abs/1805.10941), only rejects when the low half
+//lands in the biased sliver, which for a deck is about one draw in 80 million
+int rngBelow(struct rng *rng, int n){ 
+	unsigned long long m = (rngNext(rng) >> 32) * (unsigned)n;
+	unsigned low = (unsigned)m;
+	
+	if (low < (unsigned)n){
+		unsigned threshold = -(unsigned)n % (unsigned)n;
+		while (low < threshold){
+			m = (rngNext(rng) >> 32) * (unsigned)n;
+			low = (unsigned)m;
+		}
+	}
+	return (int)(m >> 32);
+}
+
+//equivalent to 2^128 calls to rngNext
+void rngJump(struct rng *rng){
+	static const unsigned long long jump[] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+	unsigned long long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	
+	for (int i = 0; i < 4; i++){
+		for (int b = 0; b < 64; b++){
+			if (jump[i] & (1ULL << b)){
+				s0 ^= rng->s[0];
+				s1 ^= rng->s[1];
+				s2 ^= rng->s[2];
+				s3 ^= rng->s[3];
+			}
+			rngNext(rng);
+		}
+	}
+	rng->s[0] = s0;
+	rng->s[1] = s1;
+	rng->s[2] = s2;
+	rng->s[3] = s3;
+}
+
+struct selfTestWorker{ //one thread's share of the self test, counts merged after join
+	struct rng rng;
+	long shuffles;
+	long first[52]; //how often each card came out on top
+	long position[52][52]; //[position][card] counts
+	pthread_t thread;
+};
+
+static void *selfTestRun(void *arg){
+	struct selfTestWorker *w = arg;
+	struct card deck[52];
+	int position;
+	
+	for (long n = 0; n < w->shuffles; n++){ //drawing the whole deck the way the game does
+		deckPopulate(deck);
+		position = 0;
+		while (position < 52){
+			deckDraw(deck, &position, &w->rng);
+		}
+		w->first[deck[0].code - 1]++;
+		for (int p = 0; p < 52; p++){
+			w->position[p][deck[p].code - 1]++;
+		}
+	}
+	return NULL;
+}
+
+//wilson-hilferty: turns a chi-square statistic into an approximate standard normal z score
+static double chiSquareZ(double chi, double dof){
+	double v = 2.0 / (9.0 * dof);
+	return (cbrt(chi / dof) - (1.0 - v)) / sqrt(v);
+}
+
+//draws out a fresh deck over and over and checks every card is equally likely in every position
+//threads run jumped copies of one stream so they never overlap
+int rngSelfTest(long shuffles, int threads, unsigned long long seed){
+	if (shuffles <= 0 || threads <= 0){
+		printf("ERROR: --rng-selftest needs a number of shuffles and at least one thread\n");
+		return(1);
+	}
+	
+	struct selfTestWorker *workers = calloc(threads, sizeof(struct selfTestWorker));
+	if (workers == NULL){
+		printf("ERROR: out of memory\n");
+		return(1);
+	}
+	
+	struct rng rng;
+	rngSeed(&rng, seed, 0);
+	for (int i = 0; i < threads; i++){
+		workers[i].rng = rng;
+		workers[i].shuffles = shuffles * (i + 1) / threads - shuffles * i / threads;
+		rngJump(&rng);
+	}
+	
+	double start = wallSeconds();
+	for (int i = 1; i < threads; i++){
+		pthread_create(&workers[i].thread, NULL, selfTestRun, &workers[i]);
+	}
+	selfTestRun(&workers[0]);
+	for (int i = 1; i < threads; i++){
+		pthread_join(workers[i].thread, NULL);
+	}
+	double seconds = wallSeconds() - start;
+	
+	//chi-square against the uniform expectation
+	double expected = (double)shuffles / 52;
+	double firstChi = 0, positionChi = 0;
+	for (int c = 0; c < 52; c++){
+		long count = 0;
+		for (int i = 0; i < threads; i++)
+			count += workers[i].first[c];
+		firstChi += (count - expected) * (count - expected) / expected;
+	}
+	for (int p = 0; p < 52; p++){
+		for (int c = 0; c < 52; c++){
+			long count = 0;
+			for (int i = 0; i < threads; i++)
+				count += workers[i].position[p][c];
+			positionChi += (count - expected) * (count - expected) / expected;
+		}
+	}
+	free(workers);
+	
+	//rows and columns of the position table each sum to the number of shuffles, (52-1)^2 degrees of freedom
+	double firstZ = chiSquareZ(firstChi, 51);
+	double positionZ = chiSquareZ(positionChi, 51*51);
+	int pass = fabs(firstZ) < 4 && fabs(positionZ) < 4;
+	
+	printf("seed:            %llu\n", seed);
+	printf("shuffles:        %ld in %.3fs (%.0f shuffles/s)\n", shuffles, seconds, seconds > 0 ? shuffles / seconds : 0.0);
+	printf("first card:      chi-square %.1f, 51 dof, z %+.2f\n", firstChi, firstZ);
+	printf("card x position: chi-square %.1f, 2601 dof, z %+.2f\n", positionChi, positionZ);
+	printf("%s\n", pass ? "PASS" : "FAIL (|z| >= 4)");
+	return pass ? 0 : 1;
+}
+
+//one step of a front to back fisher yates: swaps a random undrawn card into the draw position and takes it,
+//so a round costs one random number per card drawn instead of a 51 step shuffle, same odds as a full shuffle
+struct card deckDraw(struct card *deck, int *position, struct rng *rng){
+	int j = *position + rngBelow(rng, 52 - *position);
+	swapCard(&deck[*position], &deck[j]);
+	return deck[(*position)++];
+}
+
+//the same over every deck in the shoe, so reshuffling is just going back to position 0
+struct card shoeDraw(struct shoe *shoe, int *position, struct rng *rng){
+	int j = *position + rngBelow(rng, 52 * shoe->decks - *position);
+	swapCard(&shoe->cards[*position], &shoe->cards[j]);
+	return shoe->cards[(*position)++];
+}
+
+//decks of unshuffled cards, the cut card goes in far enough from the end that a round can't run the shoe dry
+void shoeFill(struct shoe *shoe, int decks, int penetration){
+	if (decks < 1)
+		decks = 1;
+	if (decks > SHOE_MAX_DECKS)
+		decks = SHOE_MAX_DECKS;
+	memset(shoe, 0, sizeof(*shoe));
+	shoe->decks = decks;
+	for (int d = 0; d < decks; d++){
+		deckPopulate(&shoe->cards[52 * d]);
+	}
+	
+	int size = 52 * decks;
+	shoe->cut = size * penetration / 100;
+	if (shoe->cut > size - 2 * TRICK_MAX) //both hands filling up
+		shoe->cut = size - 2 * TRICK_MAX;
+	if (shoe->cut < 1)
+		shoe->cut = 1;
+}
+
+int shoeCutReached(const struct shoe *shoe, int position){
+	return position >= shoe->cut;
+}
+
+void swapCard(struct card *i,struct card *j){ //swapping two cards via address
+	struct card temp = *i;
+	*i = *j;
+	*j = temp;
+}
+
+//times the batch evaluator against scoring the same hands one by one from their cards
+//(handRecount then handValue/handResolve), and checks all three agree
+int benchEvaluate(long hands, unsigned long long seed){
+	int batches = 64; //a pool of hands that stays in cache, evaluated over and over
+	int poolSize = batches * HAND_BATCH;
+	struct handBatch *pool = calloc(batches, sizeof(struct handBatch));
+	struct handBatch *check = calloc(batches, sizeof(struct handBatch));
+	struct hand *single = calloc(poolSize, sizeof(struct hand));
+	if (pool == NULL || check == NULL || single == NULL){
+		printf("ERROR: out of memory\n");
+		return(1);
+	}
+	
+	//random hands of one to five cards, dealt from a deck
+	struct rng rng;
+	struct card deck[52];
+	rngSeed(&rng, seed, 0);
+	for (int h = 0; h < poolSize; h++){
+		int size = 1 + rngBelow(&rng, 5);
+		int position = 0;
+		deckPopulate(deck);
+		handEmpty(&single[h]);
+		for (int slot = 0; slot < size; slot++){
+			handAdd(&single[h], deckDraw(deck, &position, &rng));
+			pool[h / HAND_BATCH].cards[slot][h % HAND_BATCH] = single[h].cards[slot].code;
+		}
+	}
+	
+	long rounds = (hands + poolSize - 1) / poolSize;
+	long checksum = 0;
+	
+	double start = wallSeconds();
+	for (long r = 0; r < rounds; r++){
+		for (int h = 0; h < poolSize; h++){
+			handRecount(&single[h]);
+			checksum += handValue(&single[h]) + handResolve(&single[h]);
+		}
+	}
+	double perHand = wallSeconds() - start;
+	
+	memcpy(check, pool, batches * sizeof(struct handBatch)); //same cards, scalar results land in check
+	start = wallSeconds();
+	for (long r = 0; r < rounds; r++){
+		for (int b = 0; b < batches; b++){
+			handBatchResolveScalar(&check[b]);
+			checksum += check[b].value[r % HAND_BATCH];
+		}
+	}
+	double scalar = wallSeconds() - start;
+	
+	start = wallSeconds();
+	for (long r = 0; r < rounds; r++){
+		for (int b = 0; b < batches; b++){
+			handBatchResolve(&pool[b]);
+			checksum += pool[b].value[r % HAND_BATCH];
+		}
+	}
+	double batched = wallSeconds() - start;
+	
+	//every hand must come out the same all three ways
+	int mismatches = 0;
+	for (int h = 0; h < poolSize; h++){
+		struct handBatch *a = &pool[h / HAND_BATCH], *b = &check[h / HAND_BATCH];
+		int i = h % HAND_BATCH;
+		if (a->value[i] != b->value[i] || a->ranking[i] != b->ranking[i]
+			|| a->value[i] != handValue(&single[h]) || a->ranking[i] != handResolve(&single[h]))
+			mismatches++;
+	}
+	
+	long evaluated = rounds * poolSize;
+#if defined(__AVX2__)
+	const char *simd = "avx2, 32 hands per instruction";
+#elif defined(__SSE2__)
+	const char *simd = "sse2, 16 hands per instruction";
+#else
+	const char *simd = "none, scalar fallback";
+#endif
+	printf("hands:     %ld (checksum %ld)\n", evaluated, checksum);
+	printf("simd:      %s\n", simd);
+	printf("per hand:  %.3fs (%.1f M hands/s)\n", perHand, evaluated / perHand / 1e6);
+	printf("scalar:    %.3fs (%.1f M hands/s)\n", scalar, evaluated / scalar / 1e6);
+	printf("batched:   %.3fs (%.1f M hands/s)\n", batched, evaluated / batched / 1e6);
+	printf("%s\n", mismatches == 0 ? "results match" : "RESULTS DIFFER");
+	
+	free(pool);
+	free(check);
+	free(single);
+	return mismatches == 0 ? 0 : 1;
+}
+
+
+//points value of a card as an index into struct deckCounts, ace 0 up to tens/pictures 9
+int cardRank(struct card cardIn){
+	return cardPoints(cardIn) - 1;
+}
+
+//counts for one or more full decks
+void deckCountsFull(struct deckCounts *counts, int decks){
+	for (int r = 0; r < RANKS; r++){
+		counts->count[r] = 4 * decks;
+	}
+	counts->count[RANKS - 1] = 16 * decks; //ten, jack, queen, king
+	counts->total = 52 * decks;
+}
+
+void deckCountsRemove(struct deckCounts *counts, struct card cardIn){
+	counts->count[cardRank(cardIn)]--;
+	counts->total--;
+}
+
+//counts the cards in deck[from] to deck[to-1], e.g. the undrawn part of the deck
+void deckCountsFromDeck(struct deckCounts *counts, const struct card *deck, int from, int to){
+	memset(counts, 0, sizeof(*counts));
+	for (int i = from; i < to; i++){
+		counts->count[cardRank(deck[i])]++;
+		counts->total++;
+	}
+}
+
+void dealerCacheInit(struct dealerCache *cache){
+	cache->capacity = 1 << 12;
+	cache->used = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->entries = calloc(cache->capacity, sizeof(struct dealerCacheEntry));
+}
+
+void dealerCacheFree(struct dealerCache *cache){
+	free(cache->entries);
+	cache->entries = NULL;
+	cache->capacity = 0;
+	cache->used = 0;
+}
+
+//fnv-1a over the key bytes
+static unsigned long long dealerKeyHash(const unsigned char *key){
+	unsigned long long hash = 0xCBF29CE484222325ULL;
+	for (int i = 0; i < DEALER_KEY; i++){
+		hash = (hash ^ key[i]) * 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+//open addressing with linear probing, returns the key's slot or the empty slot it would go in
+static struct dealerCacheEntry *dealerCacheSlot(struct dealerCacheEntry *entries, long capacity, const unsigned char *key){
+	long i = dealerKeyHash(key) & (capacity - 1);
+	while (entries[i].used && memcmp(entries[i].key, key, DEALER_KEY) != 0){
+		i = (i + 1) & (capacity - 1);
+	}
+	return &entries[i];
+}
+
+static void dealerCacheInsert(struct dealerCache *cache, const unsigned char *key, const struct dealerOdds *odds){
+	if (cache->entries == NULL) //out of memory, works without a cache
+		return;
+	
+	if (2 * (cache->used + 1) > cache->capacity){ //keeping it under half full, doubling when it isn't
+		long capacity = cache->capacity * 2;
+		struct dealerCacheEntry *entries = calloc(capacity, sizeof(struct dealerCacheEntry));
+		if (entries == NULL)
+			return;
+		for (long i = 0; i < cache->capacity; i++){
+			if (cache->entries[i].used)
+				*dealerCacheSlot(entries, capacity, cache->entries[i].key) = cache->entries[i];
+		}
+		free(cache->entries);
+		cache->entries = entries;
+		cache->capacity = capacity;
+	}
+	
+	struct dealerCacheEntry *slot = dealerCacheSlot(cache->entries, cache->capacity, key);
+	memcpy(slot->key, key, DEALER_KEY);
+	slot->odds = *odds;
+	slot->used = 1;
+	cache->used++;
+}
+
+//recursive over every card the dealer could draw next, memoized on (cards left, hard total, ace, size)
+//the dealer stops on anything that isn't "not bust" or once he has 17, same as gameDealerTurn
+static void dealerOddsFrom(struct dealerCache *cache, int hard, int aces, int size, struct deckCounts *counts, struct dealerOdds *odds){
+	int value = (aces > 0 && hard <= 11) ? hard + 10 : hard;
+	memset(odds, 0, sizeof(*odds));
+	
+	if (value > 21){
+		odds->p[OUTCOME_BUST] = 1;
+		return;
+	} else if (size == 2 && value == 21){
+		odds->p[OUTCOME_BLACKJACK] = 1;
+		return;
+	} else if (size == 5){
+		odds->p[OUTCOME_FIVE_CARD_TRICK] = 1;
+		return;
+	} else if (value >= 17){
+		odds->p[OUTCOME_17 + value - 17] = 1;
+		return;
+	} else if (counts->total == 0){ //can't happen with a full deck in play, the hand just doesn't count
+		return;
+	}
+	
+	unsigned char key[DEALER_KEY] = {0};
+	memcpy(key, counts->count, RANKS);
+	key[RANKS] = hard;
+	key[RANKS + 1] = aces > 0;
+	key[RANKS + 2] = size;
+	
+	if (cache->entries != NULL){
+		struct dealerCacheEntry *slot = dealerCacheSlot(cache->entries, cache->capacity, key);
+		if (slot->used){
+			cache->hits++;
+			*odds = slot->odds;
+			return;
+		}
+	}
+	cache->misses++;
+	
+	struct dealerOdds next;
+	for (int r = 0; r < RANKS; r++){
+		if (counts->count[r] == 0)
+			continue;
+		double p = (double)counts->count[r] / counts->total;
+		
+		counts->count[r]--;
+		counts->total--;
+		dealerOddsFrom(cache, hard + r + 1, aces + (r == 0), size + 1, counts, &next);
+		counts->count[r]++;
+		counts->total++;
+		
+		for (int o = 0; o < DEALER_OUTCOMES; o++){
+			odds->p[o] += p * next.p[o];
+		}
+	}
+	dealerCacheInsert(cache, key, odds);
+}
+
+//exact odds of how the dealer's hand finishes, drawing from the remaining cards
+void dealerOutcomeOdds(struct dealerCache *cache, const struct hand *dealer, const struct deckCounts *remaining, struct dealerOdds *odds){
+	struct deckCounts counts = *remaining;
+	dealerOddsFrom(cache, dealer->hardTotal, dealer->aces, dealer->size, &counts, odds);
+}
+
+//prints the dealer's odds for every upcard off a fresh deck, and how long a query takes cold and cached
+int printDealerOdds(){
+	const char *rankNames[RANKS] = {"A", "2", "3", "4", "5", "6", "7", "8", "9", "10"};
+	struct dealerCache cache;
+	struct dealerOdds odds;
+	struct deckCounts counts;
+	struct hand dealer;
+	
+	dealerCacheInit(&cache);
+	printf("up    bust     17       18       19       20       21       FCT      BJ\n");
+	
+	double start = wallSeconds();
+	for (int r = 0; r < RANKS; r++){
+		deckCountsFull(&counts, 1);
+		handEmpty(&dealer);
+		handAdd(&dealer, cardMake(SPADES, r + 1));
+		deckCountsRemove(&counts, dealer.cards[0]);
+		dealerOutcomeOdds(&cache, &dealer, &counts, &odds);
+		
+		printf("%-4s", rankNames[r]);
+		for (int o = 0; o < DEALER_OUTCOMES; o++){
+			printf("  %.5f", odds.p[o]);
+		}
+		printf("\n");
+	}
+	double cold = wallSeconds() - start;
+	
+	//same queries again, now answered from the cache
+	int repeats = 100000;
+	start = wallSeconds();
+	for (int i = 0; i < repeats; i++){
+		deckCountsFull(&counts, 1);
+		handEmpty(&dealer);
+		handAdd(&dealer, cardMake(SPADES, i % RANKS + 1));
+		deckCountsRemove(&counts, dealer.cards[0]);
+		dealerOutcomeOdds(&cache, &dealer, &counts, &odds);
+	}
+	double warm = wallSeconds() - start;
+	
+	printf("\ncold: %.3f ms for all 10 upcards (%ld states cached)\n", cold * 1e3, cache.used);
+	printf("warm: %.3f us per query\n", warm / repeats * 1e6);
+	dealerCacheFree(&cache);
+	return(0);
+}
+
+
+//n choose m for the small numbers the hand index needs
+static int binomial(int n, int m){
+	int result = 1;
+	for (int i = 1; i <= m; i++){
+		result = result * (n - m + i) / i;
+	}
+	return result;
+}
+
+//numbers every hand of 1 to 4 cards by rank only (order and suits don't matter) from 0 to STRATEGY_HANDS-1:
+//hands of k cards come after all the smaller hands, and within them the sorted ranks r0 <= r1 <= ...
+//are ranked by the combinatorial number system, sum of C(r_i + i, i + 1)
+int strategyHandIndex(const unsigned char *held){
+	static const int offset[5] = {0, 0, 10, 65, 285}; //hands with fewer cards: 10, 10+55, 10+55+220
+	int index = 0, k = 0;
+	
+	for (int r = 0; r < RANKS; r++){
+		for (int n = 0; n < held[r]; n++){
+			if (k == 4)
+				return -1;
+			index += binomial(r + k, k + 1);
+			k++;
+		}
+	}
+	if (k == 0)
+		return -1;
+	return offset[k] + index;
+}
+
+static int strategySlot(int upcard, int hand, int stake, int cap){
+	return ((upcard * STRATEGY_HANDS + hand) * STRATEGY_STAKES + stake) * STRATEGY_CAPS + cap;
+}
+
+//EV per $1 staked of standing on this hand, the dealer's hole card can't be making blackjack
+//since the round would already be over
+static double solverStick(struct solverWorker *w, const struct hand *player){
+	struct dealerOdds odds;
+	struct hand dealer;
+	handEmpty(&dealer);
+	handAdd(&dealer, cardMake(SPADES, w->upcard + 1));
+	dealerOutcomeOdds(&w->cache, &dealer, &w->remaining, &odds);
+	
+	enum handRankingEnum ranking = handResolve(player);
+	int value = handValue(player);
+	double ev = odds.p[OUTCOME_BUST]; //dealer bust pays evens whatever the player has
+	
+	if (ranking == BLACKJACK){ //only blackjack beats the dealer's five card trick
+		ev += 2 * odds.p[OUTCOME_FIVE_CARD_TRICK];
+	} else{
+		ev -= 2 * odds.p[OUTCOME_FIVE_CARD_TRICK];
+	}
+	for (int o = OUTCOME_17; o <= OUTCOME_21; o++){
+		if (ranking == BLACKJACK || ranking == FIVE_CARD_TRICK){
+			ev += 2 * odds.p[o];
+		} else if (value > 17 + o - OUTCOME_17){
+			ev += odds.p[o];
+		} else{ //ties go to the dealer
+			ev -= odds.p[o];
+		}
+	}
+	return ev / (1 - odds.p[OUTCOME_BLACKJACK]);
+}
+
+static double solverPlay(struct solverWorker *w, const struct hand *player, int stake, int cap);
+
+//EV of taking one more card with the given stake/cap, whether it was bought or twisted
+static double solverDraw(struct solverWorker *w, const struct hand *player, int stake, int cap){
+	double ev = 0;
+	
+	for (int r = 0; r < RANKS; r++){
+		if (w->remaining.count[r] == 0)
+			continue;
+		double p = (double)w->remaining.count[r] / w->remaining.total;
+		double value;
+		struct hand next = *player;
+		handAdd(&next, cardMake(SPADES, r + 1));
+		
+		w->remaining.count[r]--;
+		w->remaining.total--;
+		w->held[r]++;
+		switch (handResolve(&next)){
+			case BUST:
+				value = -stake;
+				break;
+			case NOT_BUST: //player takes another turn
+				value = solverPlay(w, &next, stake, cap);
+				break;
+			default: //five card trick or 21, player can't take more cards
+				value = stake * solverStick(w, &next);
+				break;
+		}
+		w->remaining.count[r]++;
+		w->remaining.total++;
+		w->held[r]--;
+		
+		ev += p * value;
+	}
+	return ev;
+}
+
+//best EV (in initial bets) of a player turn with this hand, stake and first buy, memoized and written to the table
+//buying is only ever worth it at the ends of the allowed range: the EV is the best of several straight lines
+//in the stake and first buy, so it can't peak in the middle
+static double solverPlay(struct solverWorker *w, const struct hand *player, int stake, int cap){
+	int hand = strategyHandIndex(w->held);
+	int slot = (hand * STRATEGY_STAKES + stake) * STRATEGY_CAPS + cap;
+	if (w->solved[slot])
+		return w->memo[slot];
+	
+	double best = stake * solverStick(w, player);
+	int action = STRAT_STICK;
+	double ev = solverDraw(w, player, stake, cap);
+	if (ev > best){
+		best = ev;
+		action = STRAT_TWIST;
+	}
+	if (stake + 1 < STRATEGY_STAKES){ //buy at the initial bet, sets the first buy to one bet if there isn't one
+		ev = solverDraw(w, player, stake + 1, cap == 0 ? 1 : cap);
+		if (ev > best){
+			best = ev;
+			action = STRAT_BUY_LOW;
+		}
+	}
+	if (cap != 1 && stake + 2 < STRATEGY_STAKES){ //buy at twice the initial bet, only when the first buy allows it
+		ev = solverDraw(w, player, stake + 2, 2);
+		if (ev > best){
+			best = ev;
+			action = STRAT_BUY_HIGH;
+		}
+	}
+	
+	w->solved[slot] = 1;
+	w->memo[slot] = best;
+	slot = strategySlot(w->upcard, hand, stake, cap);
+	w->table->action[slot] = action;
+	w->table->ev[slot] = (short)lround(best * 1000);
+	return best;
+}
+
+//EV per $1 of initial bet for a round where the player's first card is "first", before the second cards
+static double solverRound(struct solverWorker *w, int first){
+	double ev = 0;
+	w->remaining.count[first]--;
+	w->remaining.total--;
+	w->held[first]++;
+	
+	for (int r = 0; r < RANKS; r++){
+		if (w->remaining.count[r] == 0)
+			continue;
+		double p = (double)w->remaining.count[r] / w->remaining.total;
+		struct hand player;
+		handEmpty(&player);
+		handAdd(&player, cardMake(SPADES, first + 1));
+		handAdd(&player, cardMake(SPADES, r + 1));
+		
+		w->remaining.count[r]--;
+		w->remaining.total--;
+		w->held[r]++;
+		
+		//chance the dealer's hole card makes blackjack
+		double dealerBlackjack = 0;
+		if (w->upcard == 0){
+			dealerBlackjack = (double)w->remaining.count[RANKS - 1] / w->remaining.total;
+		} else if (w->upcard == RANKS - 1){
+			dealerBlackjack = (double)w->remaining.count[0] / w->remaining.total;
+		}
+		
+		if (handResolve(&player) == BLACKJACK){ //both blackjack is a push, otherwise straight to the dealer
+			ev += p * (1 - dealerBlackjack) * solverStick(w, &player);
+		} else{ //dealer blackjack takes twice the bet
+			ev += p * (dealerBlackjack * -2 + (1 - dealerBlackjack) * solverPlay(w, &player, 1, 0));
+		}
+		
+		w->remaining.count[r]++;
+		w->remaining.total++;
+		w->held[r]--;
+	}
+	
+	w->remaining.count[first]++;
+	w->remaining.total++;
+	w->held[first]--;
+	return ev;
+}
+
+//solver thread: takes upcards until there are none left
+static void *solverRun(void *arg){
+	struct solverWorker *w = arg;
+	int upcard;
+	
+	while ((upcard = atomic_fetch_add(w->nextUpcard, 1)) < RANKS){
+		w->upcard = upcard;
+		deckCountsFull(&w->remaining, 1);
+		w->remaining.count[upcard]--;
+		w->remaining.total--;
+		memset(w->held, 0, sizeof(w->held));
+		memset(w->solved, 0, sizeof(w->solved));
+		dealerCacheInit(&w->cache);
+		
+		for (int first = 0; first < RANKS; first++){
+			w->table->betEv[first][upcard] = solverRound(w, first);
+		}
+		dealerCacheFree(&w->cache);
+	}
+	return NULL;
+}
+
+//works out the best play for every reachable hand against every upcard (one upcard per thread at a time)
+//and writes the tables to path
+//the dealer's hole card is treated as drawn after the player's cards, the usual simplification
+int solveStrategy(const char *path, int threads){
+	struct strategyTable *table = calloc(1, sizeof(struct strategyTable));
+	struct solverWorker *workers = calloc(threads > 0 ? threads : 1, sizeof(struct solverWorker));
+	if (table == NULL || workers == NULL){
+		printf("ERROR: out of memory\n");
+		return(1);
+	}
+	if (threads <= 0)
+		threads = 1;
+	
+	memcpy(table->magic, STRATEGY_MAGIC, sizeof(table->magic));
+	table->version = STRATEGY_VERSION;
+	table->entries = STRATEGY_ENTRIES;
+	
+	atomic_int nextUpcard;
+	atomic_init(&nextUpcard, 0);
+	double start = wallSeconds();
+	for (int i = 0; i < threads; i++){
+		workers[i].table = table;
+		workers[i].nextUpcard = &nextUpcard;
+		if (i > 0)
+			pthread_create(&workers[i].thread, NULL, solverRun, &workers[i]);
+	}
+	solverRun(&workers[0]);
+	for (int i = 1; i < threads; i++){
+		pthread_join(workers[i].thread, NULL);
+	}
+	double seconds = wallSeconds() - start;
+	
+	//EV of a whole round over every first card and upcard, at the minimum bet and betting the maximum when it pays
+	double minimumBet = 0, bestBet = 0;
+	long solved = 0;
+	for (int first = 0; first < RANKS; first++){
+		for (int up = 0; up < RANKS; up++){
+			double firstCount = first == RANKS - 1 ? 16 : 4;
+			double upCount = (up == RANKS - 1 ? 16 : 4) - (up == first);
+			double p = firstCount / 52 * upCount / 51;
+			minimumBet += p * table->betEv[first][up];
+			bestBet += p * table->betEv[first][up] * (table->betEv[first][up] > 0 ? 10 : 1);
+		}
+	}
+	for (long i = 0; i < STRATEGY_ENTRIES; i++){
+		solved += table->action[i] != STRAT_NONE;
+	}
+	
+	int saved = 0;
+	FILE *fOut = fopen(path, "wb");
+	if (fOut != NULL){
+		saved = fwrite(table, sizeof(*table), 1, fOut) == 1;
+		saved &= fclose(fOut) == 0;
+	}
+	
+	printf("solved %ld player states in %.3fs\n", solved, seconds);
+	printf("EV per round, $1 bets:       %+.5f\n", minimumBet);
+	printf("EV per round, $1 or $10 bet: %+.5f\n", bestBet);
+	if (saved){
+		printf("wrote %s (%lu bytes)\n", path, (unsigned long)sizeof(*table));
+	} else{
+		printf("ERROR: couldn't write %s\n", path);
+	}
+	
+	free(table);
+	free(workers);
+	return saved ? 0 : 1;
+}
+
+//reads a table written by solveStrategy in one go, returns 0 if it's missing or from another version
+int strategyLoad(struct strategyTable *table, const char *path){
+	FILE *fIn = fopen(path, "rb");
+	if (fIn == NULL)
+		return 0;
+	int ok = fread(table, sizeof(*table), 1, fIn) == 1;
+	fclose(fIn);
+	
+	return ok && memcmp(table->magic, STRATEGY_MAGIC, sizeof(table->magic)) == 0
+		&& table->version == STRATEGY_VERSION && table->entries == STRATEGY_ENTRIES;
+}
+
+//best action for the player's turn in g, ev gets the EV in thousandths of the initial bet
+//buys that weren't at either end of the range are rounded to the nearest stake the solver knows
+enum strategyActionEnum strategyLookup(const struct strategyTable *table, const struct game *g, int *ev){
+	unsigned char held[RANKS] = {0};
+	for (int i = 0; i < g->playerHand.size; i++){
+		held[cardRank(g->playerHand.cards[i])]++;
+	}
+	int hand = strategyHandIndex(held);
+	if (hand < 0 || g->vars.initialBet <= 0)
+		return STRAT_NONE;
+	
+	int bet = g->vars.initialBet;
+	int stake = (g->vars.totalBet + bet / 2) / bet;
+	int cap = 0;
+	if (g->vars.firstBuy != -1){
+		cap = 2 * g->vars.firstBuy >= 3 * bet ? 2 : 1;
+	}
+	if (stake < 1)
+		stake = 1;
+	if (stake >= STRATEGY_STAKES)
+		stake = STRATEGY_STAKES - 1;
+	
+	int slot = strategySlot(cardRank(g->dealerHand.cards[0]), hand, stake, cap);
+	if (ev != NULL)
+		*ev = table->ev[slot];
+	return table->action[slot];
+}
+
+//plays by a solved table (context), bets the maximum only when the first two cards seen are in the player's favour
+//falls back to the dealer's rule for any state the table doesn't have
+int policyStrategy(const struct game *g, enum decisionEnum decision, int lower, int upper, void *context){
+	const struct strategyTable *table = context;
+	
+	if (decision == DECIDE_BET){
+		int first = cardRank(g->playerHand.cards[0]);
+		int up = cardRank(g->dealerHand.cards[0]);
+		return table->betEv[first][up] > 0 ? upper : lower;
+	}
+	
+	switch (strategyLookup(table, g, NULL)){
+		case STRAT_STICK:
+			return decision == DECIDE_ACTION ? STICK : lower;
+		case STRAT_TWIST:
+			return decision == DECIDE_ACTION ? TWIST : lower;
+		case STRAT_BUY_LOW:
+			return decision == DECIDE_ACTION ? BUY : lower;
+		case STRAT_BUY_HIGH:
+			return decision == DECIDE_ACTION ? BUY : upper;
+		default:
+			return policyMimicDealer(g, decision, lower, upper, NULL);
+	}
+}
+
+
+//lookup tables indexed by card code, entry 0 is the empty slot
+#define SUIT_ROW(s) s, s, s, s, s, s, s, s, s, s, s, s, s
+#define KIND_ROW 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13
+#define POINTS_ROW 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 10, 10, 10
+static const unsigned char cardSuitTable[53] = {0, SUIT_ROW(DIAMONDS), SUIT_ROW(HEARTS), SUIT_ROW(CLUBS), SUIT_ROW(SPADES)};
+static const unsigned char cardKindTable[53] = {0, KIND_ROW, KIND_ROW, KIND_ROW, KIND_ROW};
+static const unsigned char cardPointsTable[53] = {0, POINTS_ROW, POINTS_ROW, POINTS_ROW, POINTS_ROW};
+
+struct card cardMake(int suit, int kind){
+	struct card cardOut;
+	if (suit < DIAMONDS || suit > SPADES || kind < ACE || kind > KING){
+		cardOut.code = 0;
+	} else{
+		cardOut.code = (suit - 1)*13 + kind;
+	}
+	return cardOut;
+}
+
+enum suitEnum cardSuitOf(struct card cardIn){
+	return cardSuitTable[cardIn.code];
+}
+
+enum kindEnum cardKindOf(struct card cardIn){
+	return cardKindTable[cardIn.code];
+}
+
+int cardPoints(struct card cardIn){
+	return cardPointsTable[cardIn.code];
+}
+
+//names indexed by enum, 0 (an empty slot) is "NULL"
+static const char *const cardKindNames[14] = {"NULL", "ACE", "TWO", "THREE", "FOUR", "FIVE", "SIX", "SEVEN", "EIGHT", "NINE", "TEN", "JACK", "QUEEN", "KING"};
+static const char *const cardSuitNames[5] = {"NULL", "DIAMONDS", "HEARTS", "CLUBS", "SPADES"};
+
+//whole names indexed by card code, with their lengths so nothing has to count them
+struct cardName{
+	const char *text;
+	int length;
+};
+#define CARD_NAME(kind, suit) {kind " of " suit, sizeof(kind " of " suit) - 1}
+#define CARD_NAME_ROW(suit) CARD_NAME("ACE", suit), CARD_NAME("TWO", suit), CARD_NAME("THREE", suit), CARD_NAME("FOUR", suit), \
+	CARD_NAME("FIVE", suit), CARD_NAME("SIX", suit), CARD_NAME("SEVEN", suit), CARD_NAME("EIGHT", suit), CARD_NAME("NINE", suit), \
+	CARD_NAME("TEN", suit), CARD_NAME("JACK", suit), CARD_NAME("QUEEN", suit), CARD_NAME("KING", suit)
+static const struct cardName cardNameTable[53] = {{"NULL of NULL", 12}, CARD_NAME_ROW("DIAMONDS"), CARD_NAME_ROW("HEARTS"), CARD_NAME_ROW("CLUBS"), CARD_NAME_ROW("SPADES")};
+
+//fuction that returns string from enum
+const char* cardKind(struct card cardIn){
+	return cardKindNames[cardKindOf(cardIn)];
+}
+
+//returns string from enum
+const char* cardSuit(struct card cardIn){
+	return cardSuitNames[cardSuitOf(cardIn)];
+}
+
+void screenCard(struct card cardIn){
+	const struct cardName *name = &cardNameTable[cardIn.code];
+	screenWrite(name->text, name->length);
+}
+
+//C6: USER INPUT
+//one line of stdin without its newline, anything past size-1 characters is thrown away, 0 at the end of input
+int readLine(char *line, int size){
+	screenFlush(); //the prompt goes out before waiting for the answer
+	if (fgets(line, size, stdin) == NULL)
+		return 0;
+	int length = strcspn(line, "\n");
+	if (line[length] != '\n'){ //too long, the rest of the line goes too
+		int c;
+		while ((c = getchar()) != '\n' && c != EOF);
+	}
+	line[length] = '\0';
+	return 1;
+}
+
+//prints art+score etc
+void printHeader(const char *playerName, int handNumber, long money, int initialBet, int totalBet, long score){
+	SCREEN_LITERAL("______            _      ______ _            _    _            _      _____           _             \n| ___ \\          ( )     | ___ \\ |          | |  (_)          | |    /  __ \\         (_)            \n| |_/ / ___ _ __ |/ ___  | |_/ / | __ _  ___| | ___  __ _  ___| | __ | /  \\/ __ _ ___ _ _ __   ___  \n| ___ \\/ _ \\ '_ \\  / __| | ___ \\ |/ _` |/ __| |/ / |/ _` |/ __| |/ / | |    / _` / __| | '_ \\ / _ \\ \n| |_/ /  __/ | | | \\__ \\ | |_/ / | (_| | (__|   <| | (_| | (__|   <  | \\__/\\ (_| \\__ \\ | | | | (_) |\n\\____/ \\___|_| |_| |___/ \\____/|_|\\__,_|\\___|_|\\_\\ |\\__,_|\\___|_|\\_\\  \\____/\\__,_|___/_|_| |_|\\___/ \n                                                _/ |\n                                               |__/\n\n");
+	printStatus(playerName, handNumber, money, initialBet, totalBet, score);
+}
+
+void printStatus(const char *playerName, int handNumber, long money, int initialBet, int totalBet, long score){
+	SCREEN_LITERAL("PLAYER: ");
+	screenString(playerName);
+	SCREEN_LITERAL("     ROUND: ");
+	screenLong(handNumber);
+	SCREEN_LITERAL("     MONEY: ");
+	screenLong(money);
+	SCREEN_LITERAL("     INITIAL BET: $");
+	screenLong(initialBet);
+	SCREEN_LITERAL("     TOTAL BET: $");
+	screenLong(totalBet);
+	SCREEN_LITERAL("     SCORE: ");
+	screenLong(score);
+	SCREEN_LITERAL("\n\n");
+}
+
+void printHighScore(){ //courtesty of https://patorjk.com/software/taag
+	screenPrintf(" /$$   /$$ /$$$$$$  /$$$$$$  /$$   /$$  /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$  /$$$$$$$$  /$$$$$$\n");
+	screenPrintf("| $$  | $$|_  $$_/ /$$__  $$| $$  | $$ /$$__  $$ /$$__  $$ /$$__  $$| $$__  $$| $$_____/ /$$__  $$\n");
+	screenPrintf("| $$  | $$  | $$  | $$  \\__/| $$  | $$| $$  \\__/| $$  \\__/| $$  \\ $$| $$  \\ $$| $$      | $$  \\__/\n");
+	screenPrintf("| $$$$$$$$  | $$  | $$ /$$$$| $$$$$$$$|  $$$$$$ | $$      | $$  | $$| $$$$$$$/| $$$$$   |  $$$$$$\n");
+	screenPrintf("| $$__  $$  | $$  | $$|_  $$| $$__  $$ \\____  $$| $$      | $$  | $$| $$__  $$| $$__/    \\____  $$\n");
+	screenPrintf("| $$  | $$  | $$  | $$  \\ $$| $$  | $$ /$$  \\ $$| $$    $$| $$  | $$| $$  \\ $$| $$       /$$  \\ $$\n");
+	screenPrintf("| $$  | $$ /$$$$$$|  $$$$$$/| $$  | $$|  $$$$$$/|  $$$$$$/|  $$$$$$/| $$  | $$| $$$$$$$$|  $$$$$$/\n");
+	screenPrintf("|__/  |__/|______/ \\______/ |__/  |__/ \\______/  \\______/  \\______/ |__/  |__/|________/ \\______/\n\n");
+}
+
+void printGameOver(){ //courtesy of https://patorjk.com/software/taag
+	screenPrintf("  /$$$$$$   /$$$$$$  /$$      /$$ /$$$$$$$$        /$$$$$$  /$$    /$$ /$$$$$$$$ /$$$$$$$\n");
+	screenPrintf(" /$$__  $$ /$$__  $$| $$$    /$$$| $$_____/       /$$__  $$| $$   | $$| $$_____/| $$__  $$\n");
+	screenPrintf("| $$  \\__/| $$  \\ $$| $$$$  /$$$$| $$            | $$  \\ $$| $$   | $$| $$      | $$  \\ $$\n");
+	screenPrintf("| $$ /$$$$| $$$$$$$$| $$ $$/$$ $$| $$$$$         | $$  | $$|  $$ / $$/| $$$$$   | $$$$$$$/\n");
+	screenPrintf("| $$|_  $$| $$__  $$| $$  $$$| $$| $$__/         | $$  | $$ \\  $$ $$/ | $$__/   | $$__  $$\n");
+	screenPrintf("| $$  \\ $$| $$  | $$| $$\\  $ | $$| $$            | $$  | $$  \\  $$$/  | $$      | $$  \\ $$\n");
+	screenPrintf("|  $$$$$$/| $$  | $$| $$ \\/  | $$| $$$$$$$$      |  $$$$$$/   \\  $/   | $$$$$$$$| $$  | $$\n");
+	screenPrintf(" \\______/ |__/  |__/|__/     |__/|________/       \\______/     \\_/    |________/|__/  |__/\n\n\n");
 }
 
-void resetCards(struct card *deck, struct card *playerHand, struct card *dealerHand ){ //shuffles deck, empties hands 
-	deckShuffle(deck);	
-	
-	//setting all cards to null suit/kind
-	for	(int i = 0; i < 5; i++){
-		playerHand[i].suit = 0;
-		playerHand[i].kind = 0;
-		dealerHand[i].suit = 0;
-		dealerHand[i].kind = 0;
-	}
+void printArt(){ //courtesty of https://patorjk.com/software/taag
+	screenPrintf("______            _      ______ _            _    _            _      _____           _             \n| ___ \\          ( )     | ___ \\ |          | |  (_)          | |    /  __ \\         (_)            \n| |_/ / ___ _ __ |/ ___  | |_/ / | __ _  ___| | ___  __ _  ___| | __ | /  \\/ __ _ ___ _ _ __   ___  \n| ___ \\/ _ \\ '_ \\  / __| | ___ \\ |/ _` |/ __| |/ / |/ _` |/ __| |/ / | |    / _` / __| | '_ \\ / _ \\ \n| |_/ /  __/ | | | \\__ \\ | |_/ / | (_| | (__|   <| | (_| | (__|   <  | \\__/\\ (_| \\__ \\ | | | | (_) |\n\\____/ \\___|_| |_| |___/ \\____/|_|\\__,_|\\___|_|\\_\\ |\\__,_|\\___|_|\\_\\  \\____/\\__,_|___/_|_| |_|\\___/ \n                                                _/ |\n                                               |__/\n\n");
 }
 
-int titleMenu(){ //display title menu and resolve player selection
-	system("cls");
-	printArt();
-	printf("Please enter the number corresponding to your selection\n[1] NEW GAME\n[2] LOAD GAME\n[3] LEADERBOARD\n[4] INFO\n[5] QUIT\n");
-	
-	int userInput = -1;
-	while (userInput == -1){
-		userInput = singleDigitInput('1','5');
-		if (userInput != -1){
-			return userInput;
-		} else{
-			printf("Correct input only, please\n");
-		}
+void displayInfo(int page){ //two pages, the session pauses after each
+	screenClear();
+	if (page == 1){
+		screenPrintf("Program: 		blackjackUnwound!\nAuthor:			Benjamin Francis Stanton\nCreated on:		17/05/2021\nLast modified:		20/05/2021\nDescription:		A fully fleshed out game of blackjack vs a computer dealer, with betting,\n.			highscore, and save/load functionality! Player must attempt to build a\n.			winning hand from the cards dealt. Picture cards all have a value of 10,\n.			with the exception of ACE, which can be ONE or ELEVEN.\n.\n.			Hands in order as follows:\n.			BLACKJACK (ace and 10 value card),\n.			FIVE CARD TRICK (hand of five with total value under 21)\n.			TWENTY ONE (exactly 21 from a non ACE-TEN combination)\n.			HIGHCARD (less than 21)\n.			BUST (more than 21)\n.\n.			BLACKJACK and FIVE CARD TRICK are unique in that the winner receives\n.			double the staked bet.\n.\n.			Both player and dealer are dealt one card face up, at which point the\n.			player chooses his initial bet, between 1 and 10.\n.\n.			Player and dealer are then dealt a second card face down. If the dealer\n.			has BLACKJACK this is immediately made clear, and unless player has\n.			BLACKJACK, the dealer wins twice the bet.\n.			\n.			");
+	} else{
+		screenPrintf(".			Player then choses from the following:\n.			BUY: draw new card, increasing bet between initial bet and 2x initial bet\n.			TWIST: receive a new card without increasing bet\n.			STICK: receive no further cards, wait for dealer to play\n.\n.			If player goes BUST from drawing new cards, he loses.\n.\n.			Once the player is happy with his hand he sticks, and it is the dealer's\n.			turn. The dealer must continue to draw cards until he either goes BUST or\n.			his hand is equal or greater than 17.\n.\n.			If neither player goes BUST, the higher valued hand wins. If the player\n.			and the dealer both have the same valued hand, the dealer wins the round.\n.\n.			The rules have been adapted from https://www.pagat.com/banking/pontoon.html\n.			\n.			");
 	}
 }
 
-void enterToContinue(){ //simple enter to continue function
-	printf("Press ENTER to continue\n");
-	getchar();
-}
-	
-void displayFirstCard(struct card hand[5]) { //displays only first card for dealer
-	printf("1) %s of %s\n2) ?\n\n", cardKind(hand[0]), cardSuit(hand[0]));
+void slabInit(struct slab *slab, int objectSize){
+	memset(slab, 0, sizeof(*slab));
+	slab->objectSize = (objectSize + 7) & ~7; //8 byte aligned, and room for the free list link
 }
 
-void displayHand(struct card hand[5]){ //displays whole hand
-	
-	int size = handSize(hand);	
-	
-	for (int i = 0; i < size; i++){
-		printf("%d) %s of %s\n", i+1, cardKind(hand[i]), cardSuit(hand[i]));
+void *slabAlloc(struct slab *slab){
+	if (slab->freeList != NULL){
+		void *object = slab->freeList;
+		slab->freeList = *(void **)object;
+		slab->live++;
+		return object;
 	}
-	
-	int value = handValue(hand);
-	printf("Value: %d\n\n", value);
-}
-
-int handSize(struct card hand[5]){	 //returns hand size
-//counts the number of nullCards to calculate size of hand
-	int nullCounter = 0;
-	for (int i = 0; i < 5; i++){
-		if (hand[i].suit == 0) 
-			nullCounter++;
+	if (slab->end - slab->next < slab->objectSize){ //a new page, its memory is only touched as objects are handed out
+		if (slab->pageCount == slab->pageCapacity){
+			int capacity = slab->pageCapacity == 0 ? 16 : 2 * slab->pageCapacity;
+			char **pages = realloc(slab->pages, capacity * sizeof(char *));
+			if (pages == NULL)
+				return NULL;
+			slab->pages = pages;
+			slab->pageCapacity = capacity;
+		}
+		char *page = mmap(NULL, SLAB_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (page == MAP_FAILED)
+			return NULL;
+		slab->pages[slab->pageCount++] = page;
+		slab->next = page;
+		slab->end = page + SLAB_PAGE_BYTES;
 	}
-	return (5-nullCounter); 
-	
+	void *object = slab->next;
+	slab->next += slab->objectSize;
+	slab->live++;
+	return object;
 }
 
+void slabFree(struct slab *slab, void *object){
+	*(void **)object = slab->freeList;
+	slab->freeList = object;
+	slab->live--;
+}
 
-//C2: REPEITION
-//function to calculate value of a hand
-int handValue(struct card hand[5]){
-	int value = 0;
-	int size = handSize(hand);
-	int aceCounter = 0;
-	
-	
-	//iterating through each card in hand, adding 11 if ace, 10 if 10 or picture, otherwise adding value
-	for (int i = 0; i < size; i++){
-		if(hand[i].kind == ACE){
-			value += 11;
-			aceCounter ++;
-		} else if(hand[i].kind > 9 && hand[i].kind < 14){
-			value +=10;		
-		} else{
-			value += hand[i].kind;
-		}
-	}
-	
-	//for each ace in hand, if total hand value > 21, count ace value as 1 (11-10)
-	for (int i = 0; i < aceCounter; i++){
-		if (value > 21)
-			value -= 10;
+void slabDestroy(struct slab *slab){
+	for (int i = 0; i < slab->pageCount; i++){
+		munmap(slab->pages[i], SLAB_PAGE_BYTES);
 	}
-	return value;
+	free(slab->pages);
+	memset(slab, 0, sizeof(*slab));
+}
+
+//resident memory of this process (linux only), -1 if it can't be read
+static long residentBytes(){
+	FILE *fIn = fopen("/proc/self/statm", "r");
+	long size, resident = -1;
+	if (fIn == NULL)
+		return -1;
+	if (fscanf(fIn, "%ld %ld", &size, &resident) != 2)
+		resident = -1;
+	fclose(fIn);
+	return resident < 0 ? -1 : resident * sysconf(_SC_PAGESIZE);
 }
 
-//function that stars new game
-void newGame(struct card *deck, struct card *playerHand, struct card *dealerHand, struct player *currentPlayer){
-	printf("Starting New Game\nPlease enter your name! (max 16 chars, excess will be truncated)\n");
+//count live sessions held two ways: each a malloc'd struct session, and packed in a slab (unpacked into one
+//working copy per line, the way the server holds them). Reports the memory they take, how fast sessions can be
+//freed and allocated again, and the cost of a line of input on each
+int benchSessions(long count){
+	static struct rankShared board; //in memory, nothing the sessions do here is kept
+	rankSharedOpen(&board, NULL, 0);
+	struct sessionHost host;
+	memset(&host, 0, sizeof(host));
+	host.board = &board;
+	host.decks = SHOE_DECKS;
+	host.penetration = SHOE_PENETRATION;
+	host.seed = 1;
+	host.promptLines = 1;
+	void **sessions = malloc(count * sizeof(void *));
+	if (sessions == NULL){
+		printf("ERROR: out of memory\n");
+		return(1);
+	}
+	memset(sessions, 0, count * sizeof(void *)); //touched now so it isn't counted against either
 	
-	//getting player name
-	int valid = 0;
-	while (!valid){
+	struct session working;
+	struct slab slab;
+	const char *lines[3] = {"1", NULL, "1"}; //NEW GAME, a name, a $1 bet
+	char name[24]; //a session only keeps the first 15 characters
+	printf("%ld live sessions, struct session %d bytes, struct sessionPacked %d bytes\n", count, (int)sizeof(struct session), (int)sizeof(struct sessionPacked));
+	printf("%-16s %14s %14s %16s %10s\n", "", "bytes/session", "resident MB", "alloc+free/s", "ns/line");
+	for (int mode = 0; mode < 2; mode++){ //the slab first, so the heap the malloc run leaves behind doesn't count
+		long before = residentBytes();
+		if (mode == 0)
+			slabInit(&slab, sizeof(struct sessionPacked));
+		for (long i = 0; i < count; i++){
+			if (mode == 0){
+				sessions[i] = slabAlloc(&slab);
+				if (sessions[i] == NULL)
+					break;
+				sessionStart(&working, &host);
+				sessionPack(&working, sessions[i]);
+			} else{
+				sessions[i] = malloc(sizeof(struct session));
+				if (sessions[i] == NULL)
+					break;
+				sessionStart(sessions[i], &host);
+			}
+			screenClear();
+		}
 		
-		fgets(currentPlayer->name, 16, stdin); //reading stsdin
-		currentPlayer->name[strcspn(currentPlayer->name, "\n")] = '\0'; // searching for newline character and truncating string
+		//every session through the title menu to its first bet
+		double start = wallSeconds();
+		for (int l = 0; l < 3; l++){
+			for (long i = 0; i < count; i++){
+				const char *line = lines[l];
+				if (line == NULL){
+					snprintf(name, sizeof(name), "S%ld", i);
+					line = name;
+				}
+				if (mode == 0){
+					sessionUnpack(sessions[i], &host, &working);
+					sessionInput(&working, line);
+					sessionPack(&working, sessions[i]);
+				} else{
+					sessionInput(sessions[i], line);
+				}
+				screenClear();
+			}
+		}
+		double lineSeconds = wallSeconds() - start;
+		long resident = residentBytes() - before;
+		
+		//sessions ending and new ones starting: every 8th one freed and allocated again, 8 rounds
+		long churn = 0;
+		start = wallSeconds();
+		for (int round = 0; round < 8; round++){
+			for (long i = round; i < count; i += 8){
+				if (mode == 0){
+					slabFree(&slab, sessions[i]);
+					sessions[i] = slabAlloc(&slab);
+				} else{
+					free(sessions[i]);
+					sessions[i] = malloc(sizeof(struct session));
+				}
+				((char *)sessions[i])[0] = 0; //as if it were used
+				churn++;
+			}
+		}
+		double churnSeconds = wallSeconds() - start;
 		
-		if(strlen(currentPlayer->name) == 0){ //zero length
-			printf("Invalid input\n");
-		} else if (strchr(currentPlayer->name, ' ')!=NULL){ //includes space
-			printf("Invalid input (no spaces)\n");
+		const char *names[2] = {"slab, packed", "malloc, unpacked"};
+		printf("%-16s %14.1f %14.1f %16.0f %10.1f\n", names[mode], (double)resident / count, resident / 1048576.0,
+			churn / churnSeconds, lineSeconds * 1e9 / (3 * count));
+		if (mode == 0){
+			slabDestroy(&slab);
 		} else{
-			valid = 1;
+			for (long i = 0; i < count; i++)
+				free(sessions[i]);
 		}
 	}
 	
-	//populating/shuffling deck
-	deckPopulate(deck);
-	deckShuffle(deck);
-	
-	//generating empty player and dealer hand
-	struct card nullCard;
-	nullCard.suit = 0;
-	nullCard.kind = 0;
-	for (int i = 0; i < 5; i++){
-		playerHand[i] = nullCard;
-		dealerHand[i] = nullCard;
-	}
+	free(sessions);
+	rankSharedClose(&board);
+	return(0);
 }
 
-//loading just the leaderboard
-void loadLeaderboard(FILE **fIO, struct player *leaderboard){
-	*fIO = fopen("save.txt", "r"); //opening to read
-	char buffer[100];
-	
-	for (int i = 0; i < 10; i++){ //reading leaderboard
-		if(fgets(buffer, sizeof(buffer), *fIO)){
-			buffer[strcspn(buffer, "\n")] = '\0';
-			strcpy(leaderboard[i].name, buffer);
-		}
-		if(fgets(buffer, sizeof(buffer), *fIO)){
-			char *ptr;
-			leaderboard[i].score = strtol(buffer, &ptr, 10); //stringtolong
-		}
-	}	
-	
-	struct player nullPlayer;
-	nullPlayer.score = -1;
-	
-	updateLeaderboard(leaderboard, nullPlayer);
-	
-	fclose(*fIO);
+//time for the cache's idle timeout, whole seconds are plenty
+static int sessionClock(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec;
 }
 
-//loading entire game 					//C3: input file 
-void loadGame(FILE **fIO, struct player *leaderboard, struct player *currentPlayer, struct card *deck, struct card *playerHand, struct card *dealerHand, struct gameVars *loadVars){
-	*fIO = fopen("save.txt", "r"); //opening to read
-	
-	char buffer[100];
-	
-	for (int i = 0; i < 10; i++){ //reading leaderboard
-		if(fgets(buffer, sizeof(buffer), *fIO)){
-			buffer[strcspn(buffer, "\n")] = '\0';
-			strcpy(leaderboard[i].name, buffer);	//loading into array of struct 
-		}
-		if(fgets(buffer, sizeof(buffer), *fIO)){
-			char *ptr;
-			leaderboard[i].score = strtol(buffer, &ptr, 10); //stringtolong
-		}
+int sessionCacheOpen(struct sessionCache *cache, const char *path, long maxResident, int idleSeconds){
+	memset(cache, 0, sizeof(*cache));
+	cache->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600); //only ever holds sessions of this run
+	if (cache->fd < 0)
+		return 0;
+	strncpy(cache->path, path, sizeof(cache->path) - 1);
+	slabInit(&cache->slab, sizeof(struct sessionPacked));
+	cache->maxResident = maxResident < 1 ? 1 : maxResident;
+	cache->idleSeconds = idleSeconds;
+	cache->head = cache->tail = cache->freeHandles = -1;
+	return 1;
+}
+
+void sessionCacheClose(struct sessionCache *cache){
+	close(cache->fd);
+	unlink(cache->path);
+	slabDestroy(&cache->slab);
+	free(cache->entries);
+}
+
+static void sessionCacheUnlink(struct sessionCache *cache, int handle){
+	struct sessionEntry *e = &cache->entries[handle];
+	if (e->prev != -1){
+		cache->entries[e->prev].next = e->next;
+	} else{
+		cache->head = e->next;
 	}
-	
-	if(fgets(buffer, sizeof(buffer), *fIO)){ //reading name
-		buffer[strcspn(buffer, "\n")] = '\0';
-		strcpy(currentPlayer->name, buffer);
+	if (e->next != -1){
+		cache->entries[e->next].prev = e->prev;
+	} else{
+		cache->tail = e->prev;
 	}
-	
-	if(fgets(buffer, sizeof(buffer), *fIO)){ //reading score
-		char *ptr;
-		currentPlayer->score = strtol(buffer, &ptr, 10); //stringtolong
+}
+
+static void sessionCachePushFront(struct sessionCache *cache, int handle){
+	struct sessionEntry *e = &cache->entries[handle];
+	e->prev = -1;
+	e->next = cache->head;
+	if (cache->head != -1){
+		cache->entries[cache->head].prev = handle;
+	} else{
+		cache->tail = handle;
 	}
-	
-	for(int i = 0; i<52; i++){ //reading deck
-		if(fgets(buffer, sizeof(buffer), *fIO)) {
-			deck[i].suit = atoi(buffer);
-		}
-		if(fgets(buffer, sizeof(buffer), *fIO)) {
-			deck[i].kind = atoi(buffer);
-		}
+	cache->head = handle;
+}
+
+//writes a resident session to its place in the file (handle * record size) and lets its memory go
+static int sessionCacheHibernate(struct sessionCache *cache, int handle){
+	struct sessionEntry *e = &cache->entries[handle];
+	if (pwrite(cache->fd, e->resident, sizeof(struct sessionPacked), (off_t)handle * sizeof(struct sessionPacked)) != sizeof(struct sessionPacked))
+		return 0; //stays in memory, over the ceiling rather than lost
+	sessionCacheUnlink(cache, handle);
+	slabFree(&cache->slab, e->resident);
+	e->resident = NULL;
+	e->hibernated = 1;
+	cache->resident--;
+	cache->hibernations++;
+	return 1;
+}
+
+//makes room under the ceiling, least recently used first
+static void sessionCacheTrim(struct sessionCache *cache, long keep){
+	while (cache->resident > keep && cache->tail != -1){
+		if (!sessionCacheHibernate(cache, cache->tail))
+			return;
 	}
-	
-	for (int i = 0; i < 5; i++){ //reading player and dealer hands
-		if(fgets(buffer, sizeof(buffer), *fIO)){
-			playerHand[i].suit = atoi(buffer); 
-		}
-		if(fgets(buffer, sizeof(buffer), *fIO)){
-			playerHand[i].kind = atoi(buffer); 
-		}
-		if(fgets(buffer, sizeof(buffer), *fIO)){
-			dealerHand[i].suit = atoi(buffer); 
-		}
-		if(fgets(buffer, sizeof(buffer), *fIO)){
-			dealerHand[i].kind = atoi(buffer);
+}
+
+int sessionCacheAdd(struct sessionCache *cache, const struct sessionPacked *packed){
+	sessionCacheTrim(cache, cache->maxResident - 1);
+	int handle = cache->freeHandles;
+	if (handle != -1){
+		cache->freeHandles = cache->entries[handle].next;
+	} else{
+		if (cache->count == cache->capacity){
+			int capacity = cache->capacity == 0 ? 1024 : 2 * cache->capacity;
+			struct sessionEntry *entries = realloc(cache->entries, capacity * sizeof(struct sessionEntry));
+			if (entries == NULL)
+				return -1;
+			cache->entries = entries;
+			cache->capacity = capacity;
 		}
+		handle = cache->count++;
 	}
-	
-	
-	//following vars get read into the loadVars struct
-	if(fgets(buffer, sizeof(buffer), *fIO)){ 
-		char *ptr;
-		loadVars->money = strtol(buffer, &ptr, 10); //stringtolong
-	}
-	if(fgets(buffer, sizeof(buffer), *fIO)){ 
-		loadVars->handNumber = atoi(buffer);
-	}
-	if(fgets(buffer, sizeof(buffer), *fIO)){ //
-		loadVars->drawPosition = atoi(buffer);	
-	}
-	if(fgets(buffer, sizeof(buffer), *fIO)){
-		loadVars->initialBet = atoi(buffer);
-	}
-	if(fgets(buffer, sizeof(buffer), *fIO)){
-		loadVars->totalBet = atoi(buffer);
-	}
-	if(fgets(buffer, sizeof(buffer), *fIO)){
-		loadVars->firstBuy = atoi(buffer);
-	}
-	if(fgets(buffer, sizeof(buffer), *fIO)){
-		loadVars->gameState = atoi(buffer);
+	struct sessionEntry *e = &cache->entries[handle];
+	e->resident = slabAlloc(&cache->slab);
+	if (e->resident == NULL){
+		e->next = cache->freeHandles;
+		cache->freeHandles = handle;
+		return -1;
 	}
-	
-	fclose(*fIO); //closing fIO
+	*e->resident = *packed;
+	e->hibernated = 0;
+	e->lastUse = sessionClock();
+	sessionCachePushFront(cache, handle);
+	cache->resident++;
+	return handle;
 }
 
-int validFile(FILE **fIO){ 
-	int lineNumber = 1; //to ensure matches with row# in textedit
-	
-	*fIO = fopen("save.txt", "r"); //open to read
-	char ch;
-	while(!feof(*fIO)){ //while fIO isn't at end of file
-	  ch = fgetc(*fIO); //get char
-	  if(ch == '\n'){ //if char is newline, increment
-	    lineNumber++;
+//the session, read back in first if it was hibernated, and now the most recently used
+//the pointer is good until the next call that can evict (Add, Get, Sweep)
+struct sessionPacked *sessionCacheGet(struct sessionCache *cache, int handle){
+	struct sessionEntry *e = &cache->entries[handle];
+	if (e->resident == NULL){
+		sessionCacheTrim(cache, cache->maxResident - 1);
+		struct sessionPacked *packed = slabAlloc(&cache->slab);
+		if (packed == NULL)
+			return NULL;
+		if (pread(cache->fd, packed, sizeof(*packed), (off_t)handle * sizeof(*packed)) != sizeof(*packed)){
+			slabFree(&cache->slab, packed);
+			return NULL;
 		}
-	}
-
-	fclose(*fIO);
-	
-	if (lineNumber == 154){ //if there aren't exactly 153 lines, file likely corrupted
-		return 1;		
+		e->resident = packed;
+		e->hibernated = 0;
+		cache->resident++;
+		cache->loads++;
 	} else{
-		return 0;
+		sessionCacheUnlink(cache, handle);
 	}
-	
+	sessionCachePushFront(cache, handle);
+	e->lastUse = sessionClock();
+	return e->resident;
 }
 
-//function to save current game
-void saveGame(FILE **fIO, struct player *leaderboard, struct player currentPlayer, struct card *deck, struct card *playerHand, struct card *dealerHand, struct gameVars saveVars){
-	*fIO = fopen("save.txt", "w"); //opening to write
-	
-	for (int i = 0; i < 10; i++){ //writing leaderboard
-		fprintf(*fIO, "%s\n%d\n", leaderboard[i].name, leaderboard[i].score);	
+void sessionCacheRemove(struct sessionCache *cache, int handle){
+	struct sessionEntry *e = &cache->entries[handle];
+	if (e->resident != NULL){
+		sessionCacheUnlink(cache, handle);
+		slabFree(&cache->slab, e->resident);
+		e->resident = NULL;
+		cache->resident--;
 	}
-	
-	fprintf(*fIO, "%s\n%d\n", currentPlayer.name, currentPlayer.score); //writing current name
+	e->hibernated = 0;
+	e->next = cache->freeHandles;
+	cache->freeHandles = handle;
+}
 
-	for(int i = 0; i<52; i++){ //writing deck
-		fprintf(*fIO, "%d\n%d\n", deck[i].suit, deck[i].kind);
-	}
-	
-	for (int i = 0; i < 5; i++){ //writing player and dealer hands
-		fprintf(*fIO, "%d\n%d\n", playerHand[i].suit, playerHand[i].kind);
-		fprintf(*fIO, "%d\n%d\n", dealerHand[i].suit, dealerHand[i].kind);
+//hibernates everything that's sat idle past the timeout, from the least recently used end so it stops at the first that hasn't
+void sessionCacheSweep(struct sessionCache *cache){
+	if (cache->idleSeconds <= 0)
+		return;
+	int now = sessionClock();
+	while (cache->tail != -1 && now - cache->entries[cache->tail].lastUse >= cache->idleSeconds){
+		if (!sessionCacheHibernate(cache, cache->tail))
+			return;
 	}
-	
-	//current player's save variables (put into struct before function called)
-	fprintf(*fIO, "%d\n", saveVars.money);
-	fprintf(*fIO, "%d\n", saveVars.handNumber);
-	fprintf(*fIO, "%d\n", saveVars.drawPosition);
-	fprintf(*fIO, "%d\n", saveVars.initialBet);
-	fprintf(*fIO, "%d\n", saveVars.totalBet);
-	fprintf(*fIO, "%d\n", saveVars.firstBuy);
-	fprintf(*fIO, "%d\n", saveVars.gameState);
-	
-	fclose(*fIO);
-} 
+}
 
-//resets initializing leaderboard before loading values
-void resetLeaderboard(struct player *leaderboard){
-	for (int i = 0; i < 10; i++){
-		strcpy(leaderboard[i].name, "");
-		leaderboard[i].score = 0;
+//what the bench's players answer at each step: straight into a game at the minimum bet, sticking every time
+static const char *benchAnswer(int step){
+	switch (step){
+		case STEP_TITLE:
+		case STEP_BET:
+		case STEP_AGAIN:
+			return "1";
+		case STEP_ACTION:
+			return "3";
+		default: //names are filled in by the caller, everything else is ENTER
+			return "";
 	}
 }
 
-//C4: ARRAY OF STRUCT FUNCTION
-void updateLeaderboard(struct player *leaderboard, struct player currentPlayer){ //bubblesort: https://en.wikipedia.org/wiki/Bubble_sort
-	// sort leaderboard biggest->smallest via bubble sort 
-		//compares first element to the next, swapping if smaller
-		//does so until first "bubble" reaches end
-		//decreases scope of swap by 1
-		//repeats process until all elements sorted
+//count registered sessions with lines going mostly to a few of them (session u^4 * count for u uniform, so the top 10%
+//get over half the lines), once with all of them in memory and once with a tenth and the rest hibernated
+int benchHibernate(long count, unsigned long long seed){
+	static struct rankShared board;
+	rankSharedOpen(&board, NULL, 0);
+	struct sessionHost host;
+	memset(&host, 0, sizeof(host));
+	host.board = &board;
+	host.decks = SHOE_DECKS;
+	host.penetration = SHOE_PENETRATION;
+	host.seed = seed;
+	host.promptLines = 1;
+	struct session working;
+	struct sessionPacked packed;
+	struct rng rng;
+	const char *path = "bench-sessions.db";
+	long lines = 4 * count;
+	
+	printf("%ld registered sessions, %ld lines\n", count, lines);
+	printf("%-14s %12s %12s %12s %10s %10s %10s\n", "", "resident", "memory MB", "file MB", "ns/line", "hit rate", "loads");
+	for (int mode = 0; mode < 2; mode++){
+		static struct sessionCache cache;
+		long before = residentBytes();
+		if (!sessionCacheOpen(&cache, path, mode == 0 ? count : count / 10, 0)){
+			printf("ERROR: couldn't open \"%s\"\n", path);
+			return(1);
+		}
+		for (long i = 0; i < count; i++){
+			sessionStart(&working, &host);
+			sessionPack(&working, &packed);
+			screenClear();
+			if (sessionCacheAdd(&cache, &packed) == -1){
+				printf("ERROR: out of memory\n");
+				return(1);
+			}
+		}
 		
-	for (int i = 0 ; i < 10; i++){
-		for (int j = 0 ; j < 9 - i; j++) { 
-			if (leaderboard[j].score < leaderboard[j+1].score){
-		        swapPlayer(&leaderboard[j], &leaderboard[j+1]); //swap players
-      		}
-    	}
-  	}
-	
-	if (currentPlayer.score >= leaderboard[9].score){ // if current player score is >= lowest score, replace
-		leaderboard[9] = currentPlayer;
+		rngSeed(&rng, seed, 1);
+		long hits = 0;
+		char name[24];
+		double start = wallSeconds();
+		for (long l = 0; l < lines; l++){
+			double u = (rngNext(&rng) >> 11) * 0x1.0p-53;
+			int handle = (u * u) * (u * u) * count;
+			hits += cache.entries[handle].resident != NULL;
+			struct sessionPacked *p = sessionCacheGet(&cache, handle);
+			if (p == NULL){
+				printf("ERROR: couldn't read \"%s\"\n", path);
+				return(1);
+			}
+			sessionUnpack(p, &host, &working);
+			const char *line = benchAnswer(working.step);
+			if (working.step == STEP_NAME){
+				snprintf(name, sizeof(name), "H%d", handle);
+				line = name;
+			}
+			sessionInput(&working, line);
+			sessionPack(&working, p);
+			screenClear();
+		}
+		double seconds = wallSeconds() - start;
 		
-		for (int i = 0 ; i < 10; i++){
-			for (int j = 0 ; j < 9 - i; j++) { 
-				if (leaderboard[j].score < leaderboard[j+1].score){
-			        swapPlayer(&leaderboard[j], &leaderboard[j+1]); //swap players
-	      		}
-	    	}
-	  	}
+		struct stat st;
+		fstat(cache.fd, &st);
+		const char *names[2] = {"all in memory", "10% in memory"};
+		printf("%-14s %12ld %12.1f %12.1f %10.1f %9.1f%% %10ld\n", names[mode], cache.resident, (residentBytes() - before) / 1048576.0,
+			st.st_blocks * 512 / 1048576.0, seconds * 1e9 / lines, 100.0 * hits / lines, cache.loads);
+		sessionCacheClose(&cache);
 	}
+	rankSharedClose(&board);
+	return(0);
 }
 
-//C5 function with pointer to var type int
-//draws from top of deck and updates deck draw posotion
-void topDraw(struct card *hand, struct card *deck, int *position){
-	int size = handSize(hand);
-	hand[size] = deck[(*position)++];
+//game server: each connection is a session with its own game, all of them on one epoll loop
+//the protocol is lines of text, every reply ends with a prompt line like "BET $1-$10> "
+//sessions take turns on the loop, one line in and one reply out at a time, so nobody waits behind a slow client
+
+static volatile sig_atomic_t serverStop; //set by SIGINT/SIGTERM
+
+static void serverSignal(int signal){
+	(void)signal;
+	serverStop = 1;
 }
 
-//populates deck with one of each kind of card (not shuffled
-void deckPopulate(struct card deck[52]){
+//lots of sessions means lots of descriptors, so the soft limit goes up to the hard one
+static void raiseFileLimit(){
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max){
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+}
 
-	int a, b, k = 0;
-	for (a = 1; a < 5; a++){
-		for (b = 1; b < 14; b++){
-			deck[k].suit = a;
-			deck[k].kind = b;
-			k++;
-		}
+//"PORT", "HOST:PORT" or a Unix socket path (anything with a '/' in it)
+//a bare port is every interface when listening and loopback when connecting
+int serverAddress(const char *address, int listening, struct sockaddr_storage *addr, socklen_t *length){
+	memset(addr, 0, sizeof(*addr));
+	if (strchr(address, '/') != NULL){
+		struct sockaddr_un *un = (struct sockaddr_un *)addr;
+		if (strlen(address) >= sizeof(un->sun_path))
+			return 0;
+		un->sun_family = AF_UNIX;
+		strcpy(un->sun_path, address);
+		*length = sizeof(*un);
+		return 1;
 	}
 	
+	struct sockaddr_in *in = (struct sockaddr_in *)addr;
+	in->sin_family = AF_INET;
+	in->sin_addr.s_addr = htonl(listening ? INADDR_ANY : INADDR_LOOPBACK);
+	const char *port = address;
+	const char *colon = strrchr(address, ':');
+	if (colon != NULL){
+		char host[64];
+		if (colon - address >= (long)sizeof(host))
+			return 0;
+		memcpy(host, address, colon - address);
+		host[colon - address] = '\0';
+		if (inet_pton(AF_INET, host, &in->sin_addr) != 1)
+			return 0;
+		port = colon + 1;
+	}
+	int number = atoi(port);
+	if (number <= 0 || number > 65535)
+		return 0;
+	in->sin_port = htons(number);
+	*length = sizeof(*in);
+	return 1;
 }
 
-//displays deck, only for debug
-void deckDisplay(struct card deck[52]){
-	int a, b, k = 0;
-	for (a = 1; a < 5; a++){
-		for (b = 1; b < 14; b++){
-			printf("%d %d %d\n", k, deck[k].suit, deck[k].kind);
-			k++;
+//sends the reply built in the frame straight from it, only what the socket won't take yet is copied out
+//the loop is single threaded so one frame does for everyone, returns 0 if the connection is broken
+static int sessionReply(struct serverSession *s){
+	int sent = 0;
+	while (sent < screen.length){
+		ssize_t n = send(s->fd, screen.text + sent, screen.length - sent, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (n <= 0){
+			screenClear();
+			return 0;
 		}
+		sent += n;
 	}
-}
-
-void deckShuffle(struct card *deck){ //function to shuffle deck using fisher yates algorithm
-	
-	//int i set to size of deck, decreases range of swap on each loop iteration
-	for (int i = 51; i > 0; i --){
-		int j = rand() % (i + 1); //picking a random element between 0 and i
-		//swap (deck, i, j);
-		swapCard(&deck[i], &deck[j]);
+	if (sent < screen.length){ //a slow reader, rare enough that this is the one malloc a session can cost
+		s->pending = malloc(screen.length - sent);
+		if (s->pending == NULL){
+			screenClear();
+			return 0;
+		}
+		memcpy(s->pending, screen.text + sent, screen.length - sent);
+		s->pendingLength = screen.length - sent;
+		s->pendingSent = 0;
 	}
+	screenClear();
+	return 1;
 }
 
-void swapCard(struct card *i,struct card *j){ //swapping two cards via address
-	struct card temp = *i;
-	*i = *j;
-	*j = temp;
+//tells epoll whether the session is waiting to read or to write, only when that changes
+static int sessionWatch(struct server *server, struct serverSession *s, int events){
+	if (s->watching == events)
+		return 1;
+	struct epoll_event event = {.events = events, .data.ptr = s};
+	if (epoll_ctl(server->epollFd, EPOLL_CTL_MOD, s->fd, &event) != 0)
+		return 0;
+	s->watching = events;
+	return 1;
 }
 
-void swapPlayer(struct player *i, struct player *j){ //swapping two players via address
-	struct player temp = *i;
-	*i = *j;
-	*j = temp;
+//sends what's waiting, then answers the next whole line, until the socket would block
+//the session is unpacked into the server's one working copy just for the line and packed again after,
+//if it was hibernated this is where it's read back in
+//returns 0 once the session is done with (hung up, error, or a line too long for anyone to type)
+static int sessionService(struct server *server, struct serverSession *s){
+	int hungUp = 0;
+	for (;;){
+		while (s->pending != NULL){
+			ssize_t n = send(s->fd, s->pending + s->pendingSent, s->pendingLength - s->pendingSent, MSG_NOSIGNAL);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				return sessionWatch(server, s, EPOLLOUT);
+			if (n <= 0)
+				return 0;
+			s->pendingSent += n;
+			if (s->pendingSent == s->pendingLength){
+				free(s->pending);
+				s->pending = NULL;
+			}
+		}
+		if (s->done)
+			return 0;
+		
+		char *newline = memchr(s->in, '\n', s->inLength);
+		if (newline != NULL){
+			*newline = '\0';
+			if (newline > s->in && newline[-1] == '\r')
+				newline[-1] = '\0';
+			struct sessionPacked *packed = sessionCacheGet(&server->cache, s->handle);
+			if (packed == NULL)
+				return 0;
+			sessionUnpack(packed, &server->host, &server->working);
+			sessionInput(&server->working, s->in);
+			sessionPack(&server->working, packed);
+			s->done = server->working.step == STEP_DONE;
+			if (!sessionReply(s))
+				return 0;
+			int used = newline + 1 - s->in;
+			memmove(s->in, newline + 1, s->inLength - used);
+			s->inLength -= used;
+			continue;
+		}
+		if (hungUp || s->inLength == SESSION_LINE)
+			return 0;
+		
+		ssize_t n = recv(s->fd, s->in + s->inLength, SESSION_LINE - s->inLength, 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return sessionWatch(server, s, EPOLLIN);
+		if (n < 0)
+			return 0;
+		if (n == 0){ //answers whatever lines came before the hang up
+			hungUp = 1;
+		} else{
+			s->inLength += n;
+		}
+	}
 }
 
-//fuction that returns string from enum
-const char* cardKind(struct card cardIn){
-	switch (cardIn.kind){
-		case ACE:
-			return "ACE";
-			break;
-		case TWO:
-			return "TWO";
-			break;
-		case THREE:
-			return "THREE";
-			break;
-		case FOUR:
-			return "FOUR";
-			break;
-		case FIVE:
-			return "FIVE";
-			break;
-		case SIX:
-			return "SIX";
-			break;
-		case SEVEN:
-			return "SEVEN";
-			break;
-		case EIGHT:
-			return "EIGHT";
-			break;
-		case NINE:
-			return "NINE";
-			break;
-		case TEN:
-			return "TEN";
-			break;
-		case JACK:
-			return "JACK";
-			break;
-		case QUEEN:
-			return "QUEEN";
-			break;
-		case KING:
-			return "KING";
-			break;
-		default:
-			return "NULL"; 
-			break;
+//a game left underway is kept in its profile for the player to log back in to
+static void sessionClose(struct server *server, struct serverSession *s){
+	if (s->handle != -1){
+		struct sessionPacked *packed = sessionCacheGet(&server->cache, s->handle);
+		if (packed != NULL && sessionPlaying(packed->step) && server->host.profiles != NULL){
+			sessionUnpack(packed, &server->host, &server->working);
+			profileSave(server->host.profiles, &server->working.game);
+		}
+		sessionCacheRemove(&server->cache, s->handle);
+	}
+	close(s->fd);
+	free(s->pending);
+	if (s->prev != NULL){
+		s->prev->next = s->next;
+	} else{
+		server->sessions = s->next;
 	}
+	if (s->next != NULL)
+		s->next->prev = s->prev;
+	slabFree(&server->slab, s);
+	server->open--;
 }
 
-//returns string from enum
-const char* cardSuit(struct card cardIn){
-	switch (cardIn.suit){
-		case DIAMONDS:
-			return "DIAMONDS";
-			break;
-		case HEARTS:
-			return "HEARTS";
-			break;
-		case CLUBS:
-			return "CLUBS";
-			break;
-		case SPADES:
-			return "SPADES";
-			break;
-		default:
-			return "NULL"; 
-			break;
+static void serverAccept(struct server *server){
+	for (;;){
+		int fd = accept4(server->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0){
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			return; //EAGAIN once the queue is empty, or out of descriptors until someone leaves
+		}
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); //replies are small, don't hold them back (fails harmlessly on Unix sockets)
+		
+		struct serverSession *s = slabAlloc(&server->slab);
+		if (s == NULL){
+			close(fd);
+			continue;
+		}
+		memset(s, 0, sizeof(*s));
+		s->handle = -1;
+		s->fd = fd;
+		s->watching = EPOLLIN;
+		struct epoll_event event = {.events = EPOLLIN, .data.ptr = s};
+		if (epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &event) != 0){
+			close(fd);
+			slabFree(&server->slab, s);
+			continue;
+		}
+		server->open++;
+		s->next = server->sessions;
+		if (s->next != NULL)
+			s->next->prev = s;
+		server->sessions = s;
+		
+		struct sessionPacked packed;
+		sessionStart(&server->working, &server->host);
+		sessionPack(&server->working, &packed);
+		s->handle = sessionCacheAdd(&server->cache, &packed);
+		if (s->handle == -1 || !sessionReply(s) || !sessionService(server, s))
+			sessionClose(server, s);
 	}
 }
 
-//C6: USER INPUT
-//checks for singledigitinput only between two numbers
-int singleDigitInput(char lowerLimit, char upperLimit){
-	
-	int limit = 24; // buffer limit
-    char text[limit]; //throwaway buffer
-    int count = 0; 
-    int overflow = 0;
-    char t = '\0'; //initializing char
-    
-    //read an entire string
-    while( t != '\n'){
-        t = getchar();
-        text[count] = t;
-        count++;
-        if (count >= limit){
-            overflow = 1;
-            count = 0;  // reset buffer
-        }
-    }
-
-    //checking exit conditions
-    if(overflow) 
-		return(-1);            // buffer overflow
-        
-    if( count != 2 )
-		return(-1);        //multiple digits
-       
-	//checking digit range
-    if( text[0] >= (int)lowerLimit && text[0] <= (int)upperLimit )
-        return(text[0] - '0');  //returning value
-    else
-        return(-1); //returning error
-	
-}
-
-//checks for multidigit input between two numbers
-int multiDigitInput(int lowerLimit, int upperLimit){
-	int limit = 24; // buffer limit
-    char text[limit]; //throwaway buffer
-    int count = 0; 
-    int overflow = 0;
-    char t = '\0';
-    int result;
-    
-    //read an entire string
-    while( t != '\n'){
-        t = getchar();
-        text[count] = t;
-        count++;
-        if (count >= limit){
-            overflow = 1;
-            count = 0;  // reset buffer
-        }
-    }
-
-    //checking for overflow
-    if(overflow){
-		return(-1);            
-	}
-	
-	//checking all values are ints
-	int intCounter = 0;
-	for (int i = 0; i < count; i++){
-		if (text[i] >= '0' && text[i] <= '9')
-			intCounter++;
-	}
-	
-	//number of ints = number of chars counted
-	if (intCounter == count-1){
-		result = (atoi(text)); //sets result to atoi of text
+//--serve ADDR, runs until SIGINT or SIGTERM
+//sessions idle for idleSeconds, or the least recently used past memoryMB of them, hibernate to HIBERNATE_PATH
+int serve(const char *address, unsigned long long seed, int decks, int penetration, int idleSeconds, long memoryMB){
+	struct sockaddr_storage addr;
+	socklen_t length;
+	if (!serverAddress(address, 1, &addr, &length)){
+		printf("ERROR: \"%s\" isn't a port, host:port or socket path\n", address);
+		return(1);
+	}
+	raiseFileLimit();
+	
+	static struct server server; //has the leaderboard in it, too big for the stack
+	server.host.seed = seed;
+	server.host.decks = decks;
+	server.host.penetration = penetration;
+	server.host.promptLines = 1;
+	slabInit(&server.slab, sizeof(struct serverSession));
+	if (!sessionCacheOpen(&server.cache, HIBERNATE_PATH, (memoryMB << 20) / sizeof(struct sessionPacked), idleSeconds)){
+		printf("ERROR: couldn't make \"%s\" for idle sessions\n", HIBERNATE_PATH);
+		return(1);
+	}
+	server.listenFd = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (addr.ss_family == AF_UNIX){
+		unlink(((struct sockaddr_un *)&addr)->sun_path); //left over from a server that didn't get to clean up
 	} else{
-		return -1;
+		int one = 1;
+		setsockopt(server.listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	}
+	if (server.listenFd < 0 || bind(server.listenFd, (struct sockaddr *)&addr, length) != 0 || listen(server.listenFd, SERVER_BACKLOG) != 0){
+		printf("ERROR: couldn't listen on \"%s\"\n", address);
+		return(1);
 	}
+	server.epollFd = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL}; //NULL is the listening socket
+	epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.listenFd, &event);
 	
-	if (result >= lowerLimit && result <= upperLimit){
-		return result; //returns result if within limits
+	if (profileStoreOpen(&server.profiles, PROFILE_PATH)){
+		server.host.profiles = &server.profiles;
 	} else{
-		return -1;
+		printf("ERROR: couldn't open \"%s\", games won't be kept\n", PROFILE_PATH);
 	}
+	rankSharedOpen(&server.board, RANK_PATH, RANK_MERGE_MS);
+	server.host.board = &server.board;
+	
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = serverSignal; //no SA_RESTART, so epoll_wait comes back to check serverStop
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	printf("serving on %s, ctrl-c to stop\n", address);
+	fflush(stdout);
+	
+	struct epoll_event events[SERVER_EVENTS];
+	while (!serverStop){
+		int n = epoll_wait(server.epollFd, events, SERVER_EVENTS, idleSeconds > 0 ? 1000 : -1); //wakes up to look for idle sessions
+		for (int i = 0; i < n; i++){
+			struct serverSession *s = events[i].data.ptr;
+			if (s == NULL){
+				serverAccept(&server);
+			} else if (!sessionService(&server, s)){
+				sessionClose(&server, s);
+			}
+		}
+		if (n < 0 && errno != EINTR)
+			break;
+		sessionCacheSweep(&server.cache);
+	}
+	
+	//the sessions still open keep their games as if they'd dropped
+	printf("stopping, %ld sessions open, %ld served, %ld hibernated and %ld read back\n", server.open, server.host.started,
+		server.cache.hibernations, server.cache.loads);
+	close(server.listenFd);
+	if (addr.ss_family == AF_UNIX)
+		unlink(((struct sockaddr_un *)&addr)->sun_path);
+	while (server.sessions != NULL)
+		sessionClose(&server, server.sessions);
+	close(server.epollFd);
+	slabDestroy(&server.slab);
+	sessionCacheClose(&server.cache);
+	rankSharedClose(&server.board);
+	if (server.host.profiles != NULL)
+		profileStoreClose(&server.profiles);
+	return(0);
 }
 
-//prints art+score etc
-void printHeader(const char *playerName, int handNumber, long money, int initialBet, int totalBet, long score){
-	printf("______            _      ______ _            _    _            _      _____           _             \n| ___ \\          ( )     | ___ \\ |          | |  (_)          | |    /  __ \\         (_)            \n| |_/ / ___ _ __ |/ ___  | |_/ / | __ _  ___| | ___  __ _  ___| | __ | /  \\/ __ _ ___ _ _ __   ___  \n| ___ \\/ _ \\ '_ \\  / __| | ___ \\ |/ _` |/ __| |/ / |/ _` |/ __| |/ / | |    / _` / __| | '_ \\ / _ \\ \n| |_/ /  __/ | | | \\__ \\ | |_/ / | (_| | (__|   <| | (_| | (__|   <  | \\__/\\ (_| \\__ \\ | | | | (_) |\n\\____/ \\___|_| |_| |___/ \\____/|_|\\__,_|\\___|_|\\_\\ |\\__,_|\\___|_|\\_\\  \\____/\\__,_|___/_|_| |_|\\___/ \n                                                _/ |\n                                               |__/\n\n");
-	printf("PLAYER: %s     ROUND: %d     MONEY: %d     INITIAL BET: $%d     TOTAL BET: $%d     SCORE: %d\n\n", playerName, handNumber, money, initialBet, totalBet, score);
-}
-
-void printHighScore(){ //courtesty of https://patorjk.com/software/taag
-	printf(" /$$   /$$ /$$$$$$  /$$$$$$  /$$   /$$  /$$$$$$   /$$$$$$   /$$$$$$  /$$$$$$$  /$$$$$$$$  /$$$$$$\n");
-	printf("| $$  | $$|_  $$_/ /$$__  $$| $$  | $$ /$$__  $$ /$$__  $$ /$$__  $$| $$__  $$| $$_____/ /$$__  $$\n");
-	printf("| $$  | $$  | $$  | $$  \\__/| $$  | $$| $$  \\__/| $$  \\__/| $$  \\ $$| $$  \\ $$| $$      | $$  \\__/\n");
-	printf("| $$$$$$$$  | $$  | $$ /$$$$| $$$$$$$$|  $$$$$$ | $$      | $$  | $$| $$$$$$$/| $$$$$   |  $$$$$$\n");
-	printf("| $$__  $$  | $$  | $$|_  $$| $$__  $$ \\____  $$| $$      | $$  | $$| $$__  $$| $$__/    \\____  $$\n");
-	printf("| $$  | $$  | $$  | $$  \\ $$| $$  | $$ /$$  \\ $$| $$    $$| $$  | $$| $$  \\ $$| $$       /$$  \\ $$\n");
-	printf("| $$  | $$ /$$$$$$|  $$$$$$/| $$  | $$|  $$$$$$/|  $$$$$$/|  $$$$$$/| $$  | $$| $$$$$$$$|  $$$$$$/\n");
-	printf("|__/  |__/|______/ \\______/ |__/  |__/ \\______/  \\______/  \\______/ |__/  |__/|________/ \\______/\n\n");
-}
-
-void printGameOver(){ //courtesy of https://patorjk.com/software/taag
-	printf("  /$$$$$$   /$$$$$$  /$$      /$$ /$$$$$$$$        /$$$$$$  /$$    /$$ /$$$$$$$$ /$$$$$$$\n");
-	printf(" /$$__  $$ /$$__  $$| $$$    /$$$| $$_____/       /$$__  $$| $$   | $$| $$_____/| $$__  $$\n");
-	printf("| $$  \\__/| $$  \\ $$| $$$$  /$$$$| $$            | $$  \\ $$| $$   | $$| $$      | $$  \\ $$\n");
-	printf("| $$ /$$$$| $$$$$$$$| $$ $$/$$ $$| $$$$$         | $$  | $$|  $$ / $$/| $$$$$   | $$$$$$$/\n");
-	printf("| $$|_  $$| $$__  $$| $$  $$$| $$| $$__/         | $$  | $$ \\  $$ $$/ | $$__/   | $$__  $$\n");
-	printf("| $$  \\ $$| $$  | $$| $$\\  $ | $$| $$            | $$  | $$  \\  $$$/  | $$      | $$  \\ $$\n");
-	printf("|  $$$$$$/| $$  | $$| $$ \\/  | $$| $$$$$$$$      |  $$$$$$/   \\  $/   | $$$$$$$$| $$  | $$\n");
-	printf(" \\______/ |__/  |__/|__/     |__/|________/       \\______/     \\_/    |________/|__/  |__/\n\n\n");
+//load generator: connections spread over threads, each thread runs its own epoll loop
+//every connection plays the dealer's rule from the replies it gets and times each line until the reply's prompt
+static void *loadThread(void *arg){
+	struct loadWorker *w = arg;
+	struct sockaddr_storage addr;
+	socklen_t length;
+	serverAddress(w->address, 0, &addr, &length);
+	int epollFd = epoll_create1(EPOLL_CLOEXEC);
+	struct loadConnection *connections = calloc(w->sessions, sizeof(struct loadConnection));
+	struct epoll_event *events = malloc(SERVER_EVENTS * sizeof(struct epoll_event));
+	if (epollFd < 0 || connections == NULL || events == NULL){
+		w->failed = 1;
+		return NULL;
+	}
+	
+	//connecting is blocking, it's only the replies that are waited for together
+	for (int i = 0; i < w->sessions; i++)
+		connections[i].fd = -1;
+	for (int i = 0; i < w->sessions; i++){
+		struct loadConnection *c = &connections[i];
+		c->id = i;
+		c->fd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (c->fd < 0 || connect(c->fd, (struct sockaddr *)&addr, length) != 0){
+			w->failed = 1;
+			break;
+		}
+		int one = 1;
+		setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		fcntl(c->fd, F_SETFL, O_NONBLOCK);
+		struct epoll_event event = {.events = EPOLLIN, .data.ptr = c};
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, c->fd, &event);
+	}
+	
+	int open = w->sessions;
+	while (!w->failed && open > 0){
+		int n = epoll_wait(epollFd, events, SERVER_EVENTS, 1000);
+		if (n == 0){ //a second without any reply, the server is gone or stuck
+			w->failed = 1;
+			break;
+		}
+		for (int i = 0; i < n; i++){
+			struct loadConnection *c = events[i].data.ptr;
+			int hungUp = 0;
+			for (;;){
+				if (c->inLength == LOAD_REPLY){ //only the end of a reply is kept, the prompt and the hand before it
+					memmove(c->in, c->in + LOAD_REPLY / 2, LOAD_REPLY / 2);
+					c->inLength = LOAD_REPLY / 2;
+				}
+				ssize_t got = recv(c->fd, c->in + c->inLength, LOAD_REPLY - c->inLength, 0);
+				if (got > 0){
+					c->inLength += got;
+					continue;
+				}
+				if (got == 0)
+					hungUp = 1;
+				else if (errno == EINTR)
+					continue;
+				else if (errno != EAGAIN && errno != EWOULDBLOCK)
+					hungUp = 1;
+				break;
+			}
+			
+			int replied = hungUp || (c->inLength >= 2 && c->in[c->inLength - 2] == '>' && c->in[c->inLength - 1] == ' ');
+			if (!replied)
+				continue;
+			if (c->sent != 0 && w->done < w->actions)
+				w->latencies[w->done++] = (wallSeconds() - c->sent) * 1e6;
+			c->sent = 0;
+			
+			if (hungUp || w->done >= w->actions){ //game over, or finished: a game over comes back as a new player
+				close(c->fd);
+				c->fd = -1;
+				c->inLength = 0;
+				if (!hungUp || w->done >= w->actions){
+					open--;
+					continue;
+				}
+				c->fd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+				if (c->fd < 0 || connect(c->fd, (struct sockaddr *)&addr, length) != 0){
+					w->failed = 1;
+					break;
+				}
+				int one = 1;
+				setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+				fcntl(c->fd, F_SETFL, O_NONBLOCK);
+				struct epoll_event event = {.events = EPOLLIN, .data.ptr = c};
+				epoll_ctl(epollFd, EPOLL_CTL_ADD, c->fd, &event);
+				continue;
+			}
+			
+			//the prompt is the start of the last line
+			c->in[c->inLength] = '\0';
+			char *prompt = c->in + c->inLength;
+			while (prompt > c->in && prompt[-1] != '\n')
+				prompt--;
+			char line[32];
+			if (strncmp(prompt, "NAME", 4) == 0){ //a new player for every game
+				snprintf(line, sizeof(line), "L%dx%dx%d\n", w->id, c->id, c->generation++);
+			} else if (strncmp(prompt, "ENTER", 5) == 0 || strncmp(prompt, "PROFILE", 7) == 0){
+				snprintf(line, sizeof(line), "\n");
+			} else if (strncmp(prompt, "BET", 3) == 0){
+				snprintf(line, sizeof(line), "%d\n", 1 + rngBelow(&w->rng, 3));
+			} else if (strncmp(prompt, "ACTION", 6) == 0){
+				char *value = NULL;
+				for (char *at = c->in; (at = strstr(at, "Value: ")) != NULL; at++)
+					value = at; //the player's hand is shown last
+				snprintf(line, sizeof(line), "%d\n", value != NULL && atoi(value + 7) < 17 ? TWIST : STICK);
+			} else if (strncmp(prompt, "BUY", 3) == 0){
+				snprintf(line, sizeof(line), "%d\n", atoi(prompt + 5));
+			} else{
+				snprintf(line, sizeof(line), "1\n");
+			}
+			c->inLength = 0;
+			c->sent = wallSeconds();
+			if (send(c->fd, line, strlen(line), MSG_NOSIGNAL) != (ssize_t)strlen(line))
+				w->failed = 1; //a one line request always fits in the socket buffer
+		}
+	}
+	
+	for (int i = 0; i < w->sessions; i++){
+		if (connections[i].fd >= 0)
+			close(connections[i].fd);
+	}
+	free(connections);
+	free(events);
+	close(epollFd);
+	return NULL;
 }
 
-void printArt(){ //courtesty of https://patorjk.com/software/taag
-	printf("______            _      ______ _            _    _            _      _____           _             \n| ___ \\          ( )     | ___ \\ |          | |  (_)          | |    /  __ \\         (_)            \n| |_/ / ___ _ __ |/ ___  | |_/ / | __ _  ___| | ___  __ _  ___| | __ | /  \\/ __ _ ___ _ _ __   ___  \n| ___ \\/ _ \\ '_ \\  / __| | ___ \\ |/ _` |/ __| |/ / |/ _` |/ __| |/ / | |    / _` / __| | '_ \\ / _ \\ \n| |_/ /  __/ | | | \\__ \\ | |_/ / | (_| | (__|   <| | (_| | (__|   <  | \\__/\\ (_| \\__ \\ | | | | (_) |\n\\____/ \\___|_| |_| |___/ \\____/|_|\\__,_|\\___|_|\\_\\ |\\__,_|\\___|_|\\_\\  \\____/\\__,_|___/_|_| |_|\\___/ \n                                                _/ |\n                                               |__/\n\n");
+static int compareFloat(const void *a, const void *b){
+	float x = *(const float *)a, y = *(const float *)b;
+	return (x > y) - (x < y);
 }
 
-void displayInfo(){
-	system("cls");
-	printf("Program: 		blackjackUnwound!\nAuthor:			Benjamin Francis Stanton\nCreated on:		17/05/2021\nLast modified:		20/05/2021\nDescription:		A fully fleshed out game of blackjack vs a computer dealer, with betting,\n.			highscore, and save/load functionality! Player must attempt to build a\n.			winning hand from the cards dealt. Picture cards all have a value of 10,\n.			with the exception of ACE, which can be ONE or ELEVEN.\n.\n.			Hands in order as follows:\n.			BLACKJACK (ace and 10 value card),\n.			FIVE CARD TRICK (hand of five with total value under 21)\n.			TWENTY ONE (exactly 21 from a non ACE-TEN combination)\n.			HIGHCARD (less than 21)\n.			BUST (more than 21)\n.\n.			BLACKJACK and FIVE CARD TRICK are unique in that the winner receives\n.			double the staked bet.\n.\n.			Both player and dealer are dealt one card face up, at which point the\n.			player chooses his initial bet, between 1 and 10.\n.\n.			Player and dealer are then dealt a second card face down. If the dealer\n.			has BLACKJACK this is immediately made clear, and unless player has\n.			BLACKJACK, the dealer wins twice the bet.\n.			\n.			");
-	enterToContinue();
-	system("cls");
-	printf(".			Player then choses from the following:\n.			BUY: draw new card, increasing bet between initial bet and 2x initial bet\n.			TWIST: receive a new card without increasing bet\n.			STICK: receive no further cards, wait for dealer to play\n.\n.			If player goes BUST from drawing new cards, he loses.\n.\n.			Once the player is happy with his hand he sticks, and it is the dealer's\n.			turn. The dealer must continue to draw cards until he either goes BUST or\n.			his hand is equal or greater than 17.\n.\n.			If neither player goes BUST, the higher valued hand wins. If the player\n.			and the dealer both have the same valued hand, the dealer wins the round.\n.\n.			The rules have been adapted from https://www.pagat.com/banking/pontoon.html\n.			\n.			");
-	enterToContinue();
+//--load ADDR [N], N actions from sessions connections over threads threads, then the latency percentiles
+int loadServer(const char *address, long actions, int sessions, int threads, unsigned long long seed){
+	struct sockaddr_storage addr;
+	socklen_t length;
+	if (!serverAddress(address, 0, &addr, &length)){
+		printf("ERROR: \"%s\" isn't a port, host:port or socket path\n", address);
+		return(1);
+	}
+	if (threads > sessions)
+		threads = sessions;
+	if (actions <= 0 || threads <= 0){
+		printf("ERROR: --load needs actions and at least one session\n");
+		return(1);
+	}
+	raiseFileLimit();
+	
+	struct loadWorker *workers = calloc(threads, sizeof(struct loadWorker));
+	if (workers == NULL){
+		printf("ERROR: out of memory\n");
+		return(1);
+	}
+	double start = wallSeconds();
+	for (int t = 0; t < threads; t++){
+		struct loadWorker *w = &workers[t];
+		w->address = address;
+		w->id = t;
+		w->sessions = sessions / threads + (t < sessions % threads);
+		w->actions = actions / threads + (t < actions % threads);
+		w->latencies = malloc(w->actions * sizeof(float));
+		rngSeed(&w->rng, seed, t);
+		if (w->latencies == NULL || pthread_create(&w->thread, NULL, loadThread, w) != 0){
+			printf("ERROR: couldn't start the load threads\n");
+			return(1);
+		}
+	}
+	long done = 0;
+	int failed = 0;
+	for (int t = 0; t < threads; t++){
+		pthread_join(workers[t].thread, NULL);
+		done += workers[t].done;
+		failed |= workers[t].failed;
+	}
+	double seconds = wallSeconds() - start;
+	
+	float *all = malloc((done + 1) * sizeof(float));
+	long n = 0;
+	for (int t = 0; t < threads; t++){
+		memcpy(all + n, workers[t].latencies, workers[t].done * sizeof(float));
+		n += workers[t].done;
+		free(workers[t].latencies);
+	}
+	free(workers);
+	if (failed)
+		printf("ERROR: lost the server after %ld actions\n", done);
+	if (done > 0){
+		qsort(all, done, sizeof(float), compareFloat);
+		printf("%ld actions, %d sessions, %d threads, %.3fs (%.0f actions/s)\n", done, sessions, threads, seconds, done / seconds);
+		printf("latency us: p50 %.1f  p99 %.1f  max %.1f\n", all[done / 2], all[done * 99 / 100], all[done - 1]);
+	}
+	free(all);
+	return(failed);
 }
-